@@ -0,0 +1,561 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#include <cmath>
+#include <limits>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "AMG.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+std::string AMG::type_name() { return "AMG"; }
+common::ComponentBuilder< AMG, common::Component, LibLSS > Builder_AMG;
+
+
+namespace {
+
+
+/// Sparse matrix transpose, B = A' (0-based, A with n rows and m columns)
+void transpose(const int& n, const int& m,
+  const std::vector< int >& ia, const std::vector< int >& ja, const std::vector< double >& a,
+  std::vector< int >& ib, std::vector< int >& jb, std::vector< double >& b)
+{
+  ib.assign(m+1,0);
+  for (int k=0; k<ia[n]; ++k)
+    ++ib[ja[k]+1];
+  for (int j=0; j<m; ++j)
+    ib[j+1] += ib[j];
+  jb.resize(ia[n]);
+  b .resize(ia[n]);
+  std::vector< int > pos(ib.begin(),ib.end()-1);
+  for (int i=0; i<n; ++i)
+    for (int k=ia[i]; k<ia[i+1]; ++k) {
+      const int p = pos[ja[k]]++;
+      jb[p] = i;
+      b [p] = a[k];
+    }
+}
+
+
+/// Sparse matrix product, C = A B (0-based, A with n rows and B with m
+/// columns), row by row accumulating on the positions of a marker array
+void multiply(const int& n, const int& m,
+  const std::vector< int >& ia, const std::vector< int >& ja, const std::vector< double >& a,
+  const std::vector< int >& ib, const std::vector< int >& jb, const std::vector< double >& b,
+  std::vector< int >& ic, std::vector< int >& jc, std::vector< double >& c)
+{
+  std::vector< int > mark(m,-1);
+  ic.assign(n+1,0);
+  for (int i=0; i<n; ++i)
+    for (int k=ia[i]; k<ia[i+1]; ++k)
+      for (int l=ib[ja[k]]; l<ib[ja[k]+1]; ++l)
+        if (mark[jb[l]]!=i) {
+          mark[jb[l]] = i;
+          ++ic[i+1];
+        }
+  for (int i=0; i<n; ++i)
+    ic[i+1] += ic[i];
+
+  jc.resize(ic[n]);
+  c.assign(ic[n],0.);
+  mark.assign(m,-1);
+  for (int i=0; i<n; ++i)
+    for (int k=ia[i], p=ic[i]; k<ia[i+1]; ++k)
+      for (int l=ib[ja[k]]; l<ib[ja[k]+1]; ++l) {
+        const int j = jb[l];
+        if (mark[j]<ic[i]) {
+          mark[j] = p;
+          jc[p++] = j;
+        }
+        c[mark[j]] += a[k]*b[l];
+      }
+}
+
+
+/// Aggregation of the level nodes, by strength of connection |a_ij| >=
+/// theta sqrt(|a_ii a_jj|), in three passes: (1) nodes with no aggregated
+/// strong neighbours form an aggregate with them, (2) remaining nodes join a
+/// strong neighbour's aggregate from (1), and (3) form new aggregates with
+/// their free strong neighbours (nodes without strong neighbours are left
+/// unaggregated, for the smoother); returns the number of aggregates
+int aggregate(const AMG::level_t& L, const double& theta, std::vector< int >& agg)
+{
+  const int n = L.n;
+
+  // strongly connected neighbours
+  std::vector< int > sia(n+1,0), sja;
+  sja.reserve(L.ia[n]);
+  for (int i=0; i<n; ++i) {
+    for (int k=L.ia[i]; k<L.ia[i+1]; ++k) {
+      const int j = L.ja[k];
+      if (j!=i && L.a[k]!=0. && L.a[k]*L.a[k]*std::abs(L.dinv[i]*L.dinv[j])>=theta*theta)
+        sja.push_back(j);
+    }
+    sia[i+1] = static_cast< int >(sja.size());
+  }
+
+  int nc = 0;
+  agg.assign(n,-1);
+  for (int i=0; i<n; ++i) {
+    bool free = (sia[i]<sia[i+1] && agg[i]<0);
+    for (int k=sia[i]; free && k<sia[i+1]; ++k)
+      free = (agg[sja[k]]<0);
+    if (free) {
+      agg[i] = nc;
+      for (int k=sia[i]; k<sia[i+1]; ++k)
+        agg[sja[k]] = nc;
+      ++nc;
+    }
+  }
+
+  const std::vector< int > agg1(agg);
+  for (int i=0; i<n; ++i)
+    for (int k=sia[i]; agg[i]<0 && k<sia[i+1]; ++k)
+      agg[i] = agg1[sja[k]];
+
+  for (int i=0; i<n; ++i)
+    if (agg[i]<0 && sia[i]<sia[i+1]) {
+      agg[i] = nc;
+      for (int k=sia[i]; k<sia[i+1]; ++k)
+        if (agg[sja[k]]<0)
+          agg[sja[k]] = nc;
+      ++nc;
+    }
+  return nc;
+}
+
+
+/// Dense LU factorization with partial pivoting, of a (small) level operator;
+/// singular pivots are zeroed, so their solution component is left zero
+void lu_factor(const AMG::level_t& L, std::vector< double >& lu, std::vector< int >& piv)
+{
+  const int n = L.n;
+  lu.assign(n*n,0.);
+  piv.resize(n);
+  double amax = 0.;
+  for (int i=0; i<n; ++i)
+    for (int k=L.ia[i]; k<L.ia[i+1]; ++k) {
+      lu[i*n+L.ja[k]] += L.a[k];
+      amax = std::max(amax,std::abs(L.a[k]));
+    }
+  const double tiny = amax*n*std::numeric_limits< double >::epsilon();
+
+  for (int j=0; j<n; ++j) {
+    int p = j;
+    for (int i=j+1; i<n; ++i)
+      if (std::abs(lu[i*n+j])>std::abs(lu[p*n+j]))
+        p = i;
+    piv[j] = p;
+    if (p!=j)
+      std::swap_ranges(&lu[j*n],&lu[j*n]+n,&lu[p*n]);
+    const double d = lu[j*n+j];
+    if (std::abs(d)<=tiny) {
+      for (int i=j; i<n; ++i)
+        lu[i*n+j] = 0.;
+      continue;
+    }
+    for (int i=j+1; i<n; ++i) {
+      const double l = (lu[i*n+j] /= d);
+      for (int c=j+1; c<n; ++c)
+        lu[i*n+c] -= l*lu[j*n+c];
+    }
+  }
+}
+
+
+/// Dense LU solve, in place
+void lu_solve(const int& n, const std::vector< double >& lu, const std::vector< int >& piv, double* x)
+{
+  for (int j=0; j<n; ++j)
+    std::swap(x[j],x[piv[j]]);
+  for (int i=0; i<n; ++i)
+    for (int c=0; c<i; ++c)
+      x[i] -= lu[i*n+c]*x[c];
+  for (int i=n-1; i>=0; --i) {
+    for (int c=i+1; c<n; ++c)
+      x[i] -= lu[i*n+c]*x[c];
+    x[i] = (lu[i*n+i]!=0.? x[i]/lu[i*n+i] : 0.);
+  }
+}
+
+
+}  // namespace
+
+
+AMG::AMG(const std::string& name, const size_t& _size_i, const size_t& _size_j, const size_t& _size_k)
+  : detail::solverbase(name)
+{
+  // framework scripting: options and properties
+  m_rtol    = 1.e-5;
+  m_maxits  = 100;
+  m_monitor = false;
+  m_pc_refresh = 1;
+  options().add("rtol",      m_rtol          ).link_to(&m_rtol          ).mark_basic().description("relative tolerance, solving stops when ||residual||/||initial residual|| <= rtol (default 1.e-5)");
+  options().add("maxits",    m_maxits        ).link_to(&m_maxits        ).mark_basic().description("maximum number of iterations (V-cycles) to perform (default 100)");
+  options().add("theta",     m_par.theta     ).link_to(&m_par.theta     ).mark_basic().description("strength of connection threshold, nodes i and j are aggregated if |a_ij| >= theta sqrt(|a_ii a_jj|) (default 0.08)");
+  options().add("coarse",    m_par.coarse    ).link_to(&m_par.coarse    ).mark_basic().description("coarsening stops at levels of this size or less, solved directly (default 100)");
+  options().add("maxlevels", m_par.maxlevels ).link_to(&m_par.maxlevels ).mark_basic().description("maximum number of multigrid levels (default 20)");
+  options().add("smoother",  m_par.smoother  ).link_to(&m_par.smoother  ).mark_basic().description("smoother, \"jacobi\" (parallel) or \"gs\" (symmetric Gauss-Seidel, default)");
+  options().add("sweeps",    m_par.sweeps    ).link_to(&m_par.sweeps    ).mark_basic().description("number of pre- and post-smoothing sweeps (default 1)");
+  options().add("monitor",   m_monitor       ).link_to(&m_monitor       ).mark_basic().description("if each iteration should be printed (default false)");
+  options().add("PCRefresh", m_pc_refresh    ).link_to(&m_pc_refresh    ).mark_basic().description("recalculate multigrid hierarchy every given number of solves, 0 for only when the matrix structure changes (default 1)");
+
+  properties().add("levels",    int(0));
+  properties().add("complexity",double(0.));
+
+  linearsystem< double >::initialize(_size_i,_size_j,_size_k);
+}
+
+
+AMG& AMG::solve()
+{
+  if (!m_A.m_size.is_square_size())
+    throw std::runtime_error("AMG: system matrix must be square.");
+  matrix_t::matrix_compressed_t& A = m_A.compress();
+
+  int err = 0;
+  if ((err=setup(A,m_A.pattern_version(),m_pc_refresh,m_par,m_h)))
+    throw std::runtime_error("AMG: " + setup_message(err));
+  properties()["levels"]     = static_cast< int >(m_h.levels.size());
+  properties()["complexity"] = complexity(m_h);
+  if (m_monitor) {
+    CFinfo << "AMG: levels/operator complexity: " << m_h.levels.size() << '/' << complexity(m_h) << " (rows:";
+    for (size_t l=0; l<m_h.levels.size(); ++l)
+      CFinfo << ' ' << m_h.levels[l].n;
+    CFinfo << ')' << CFendl;
+  }
+
+  // solve each right-hand side, iterating x += M^-1 (b - A x) by V-cycles
+  // with residual r and correction e workspace vectors
+  const int n = static_cast< int >(size(0));
+  m_work.resize(2*n);
+  double *r = &m_work[0], *e = &m_work[n];
+  int itsmax = 0;
+  double resmax = 0.;
+  bool converged = true;
+  for (size_t k=0; k<size(2); ++k) {
+    double *x = &m_x.a[k*n], *b = &m_b.a[k*n];
+
+    m_A.multi(x,r,1,-1.);
+    for (int i=0; i<n; ++i)
+      r[i] += b[i];
+    double
+      res = std::sqrt(dot(n,r,r)),
+      eps = m_rtol*res;
+    int its = 0;
+
+    while (res>eps && its<m_maxits) {
+      ++its;
+      vcycle(m_h,r,e);
+      #pragma omp parallel for schedule(static)
+      for (int i=0; i<n; ++i)
+        x[i] += e[i];
+      m_A.multi(x,r,1,-1.);
+      double rr = 0.;
+      #pragma omp parallel for schedule(static) reduction(+:rr)
+      for (int i=0; i<n; ++i) {
+        r[i] += b[i];
+        rr += r[i]*r[i];
+      }
+      res = std::sqrt(rr);
+
+      if (m_monitor) {
+        CFinfo << "AMG: iteration/residual: " << its << '/' << res;
+        if (size(2)>1)
+          CFinfo << " (rhs " << k << ')';
+        CFinfo << CFendl;
+      }
+    }
+
+    itsmax = std::max(itsmax,its);
+    resmax = std::max(resmax,res);
+    converged = converged && res<=eps;
+  }
+
+  properties()["iterations"] = itsmax;
+  properties()["residual"]   = resmax;
+  if (m_monitor)
+    CFinfo << "AMG: iterations/residual: " << itsmax << '/' << resmax << CFendl;
+  if (!converged)
+    throw std::runtime_error("AMG: convergence not achieved in maxits iterations.");
+
+  return *this;
+}
+
+
+AMG& AMG::copy(const AMG& _other)
+{
+  detail::solverbase::copy(_other);
+  m_rtol    = _other.m_rtol;
+  m_maxits  = _other.m_maxits;
+  m_par     = _other.m_par;
+  m_monitor = _other.m_monitor;
+  m_pc_refresh = _other.m_pc_refresh;
+  m_h = hierarchy_t();
+  return *this;
+}
+
+
+AMG& AMG::swap(AMG& _other)
+{
+  detail::solverbase::swap(_other);
+  m_h = _other.m_h = hierarchy_t();
+  return *this;
+}
+
+
+int AMG::setup(const matrix_t::matrix_compressed_t& A, const size_t& pattern, const int& refresh, const parameters_t& par, hierarchy_t& h)
+{
+  if (par.theta<0. || par.coarse<1 || par.maxlevels<1 || par.sweeps<1)
+    return -1;
+  if (par.smoother!="jacobi" && par.smoother!="gs")
+    return -2;
+
+  // hierarchy is kept while matrix structure and parameters are unchanged,
+  // and for the given number of solves
+  const bool recalculate =
+    h.pattern!=pattern || h.levels.empty() || (refresh>0 && h.age>=refresh) ||
+    h.par.theta!=par.theta || h.par.coarse!=par.coarse || h.par.maxlevels!=par.maxlevels ||
+    h.par.smoother!=par.smoother || h.par.sweeps!=par.sweeps;
+  if (!recalculate) {
+    ++h.age;
+    return 0;
+  }
+  h.pattern = 0;
+  h.age     = 1;
+  h.par     = par;
+  h.levels.assign(1,level_t());
+  h.lu .clear();
+  h.piv.clear();
+
+  // finest level operator (0-based copy of the matrix)
+  {
+    level_t& L = h.levels.front();
+    L.n = A.nnu;
+    L.ia.resize(A.nnu+1);
+    for (int i=0; i<=A.nnu; ++i)
+      L.ia[i] = A.ia[i]-1;
+    L.ja.resize(L.ia[L.n]);
+    for (int k=0; k<L.ia[L.n]; ++k)
+      L.ja[k] = A.ja[k]-1;
+    L.a.assign(A.a.begin(),A.a.begin()+L.ia[L.n]);
+  }
+
+  for (;;) {
+    level_t& L = h.levels.back();
+    const int n = L.n;
+
+    // inverse diagonal, and Jacobi weight 4/3/rho(D^-1 A) by a Gershgorin
+    // bound of the spectral radius (finest level diagonal must be non-zero)
+    L.dinv.assign(n,0.);
+    double rho = 0.;
+    for (int i=0; i<n; ++i) {
+      double d = 0., s = 0.;
+      for (int k=L.ia[i]; k<L.ia[i+1]; ++k) {
+        if (L.ja[k]==i)
+          d += L.a[k];
+        s += std::abs(L.a[k]);
+      }
+      if (d==0. && h.levels.size()==1)
+        return i+1;
+      if (d!=0.) {
+        L.dinv[i] = 1./d;
+        rho = std::max(rho,s/std::abs(d));
+      }
+    }
+    L.omega = (rho>0.? 4./(3.*rho) : 1.);
+    L.x.resize(n);
+    L.b.resize(n);
+    L.r.resize(n);
+
+    if (n<=par.coarse || static_cast< int >(h.levels.size())>=par.maxlevels)
+      break;
+
+    // aggregates, stopping if coarsening stagnates
+    std::vector< int > agg;
+    const int nc = aggregate(L,par.theta,agg);
+    if (nc==0 || nc>=n)
+      break;
+
+    // tentative prolongator T (piecewise constant, columns of unit norm) and
+    // smoothed prolongator P = (I - omega D^-1 A) T
+    std::vector< double > t(n,0.);
+    {
+      std::vector< int > count(nc,0);
+      for (int i=0; i<n; ++i)
+        if (agg[i]>=0)
+          ++count[agg[i]];
+      for (int i=0; i<n; ++i)
+        if (agg[i]>=0)
+          t[i] = 1./std::sqrt(static_cast< double >(count[agg[i]]));
+    }
+    std::vector< int > mark(nc,-1);
+    L.pia.assign(1,0);
+    L.pja.clear();
+    L.pa .clear();
+    for (int i=0; i<n; ++i) {
+      const int row = static_cast< int >(L.pja.size());
+      if (agg[i]>=0) {
+        mark[agg[i]] = row;
+        L.pja.push_back(agg[i]);
+        L.pa .push_back(t[i]);
+      }
+      for (int k=L.ia[i]; k<L.ia[i+1]; ++k) {
+        const int j = L.ja[k];
+        if (agg[j]<0)
+          continue;
+        if (mark[agg[j]]<row) {
+          mark[agg[j]] = static_cast< int >(L.pja.size());
+          L.pja.push_back(agg[j]);
+          L.pa .push_back(0.);
+        }
+        L.pa[mark[agg[j]]] -= L.omega*L.dinv[i]*L.a[k]*t[j];
+      }
+      L.pia.push_back(static_cast< int >(L.pja.size()));
+    }
+
+    // restriction R = P', and Galerkin coarse level operator R A P
+    transpose(n,nc,L.pia,L.pja,L.pa,L.ria,L.rja,L.ra);
+    std::vector< int > apia, apja;
+    std::vector< double > apa;
+    multiply(n,nc,L.ia,L.ja,L.a,L.pia,L.pja,L.pa,apia,apja,apa);
+    level_t C;
+    C.n = nc;
+    multiply(nc,nc,L.ria,L.rja,L.ra,apia,apja,apa,C.ia,C.ja,C.a);
+    h.levels.push_back(C);
+  }
+
+  // coarsest level direct solve, if small enough (otherwise it is smoothed)
+  if (h.levels.back().n<=par.coarse)
+    lu_factor(h.levels.back(),h.lu,h.piv);
+  h.pattern = pattern;
+  return 0;
+}
+
+
+std::string AMG::setup_message(const int& err)
+{
+  std::ostringstream msg;
+  msg << "multigrid setup error " << err << ": ";
+  err>  0? msg << "zero diagonal entry at row " << (err-1) << '.' :
+  err==-1? msg << "theta should be non-negative, and coarse, maxlevels and sweeps positive." :
+  err==-2? msg << "unknown smoother, should be \"jacobi\" or \"gs\"." :
+           msg << "unknown error.";
+  return msg.str();
+}
+
+
+void AMG::vcycle(hierarchy_t& h, const double* b, double* x)
+{
+  level_t& L = h.levels.front();
+  std::copy(b,b+L.n,L.b.begin());
+  vcycle(h,0);
+  std::copy(L.x.begin(),L.x.end(),x);
+}
+
+
+double AMG::complexity(const hierarchy_t& h)
+{
+  double nnz = 0.;
+  for (size_t l=0; l<h.levels.size(); ++l)
+    nnz += static_cast< double >(h.levels[l].ia.back());
+  return (h.levels.empty() || h.levels.front().ia.back()==0? 0. : nnz/h.levels.front().ia.back());
+}
+
+
+void AMG::vcycle(hierarchy_t& h, const size_t& l)
+{
+  level_t& L = h.levels[l];
+  const int n = L.n;
+  std::fill(L.x.begin(),L.x.end(),0.);
+
+  // coarsest level: direct solve (or smoothing)
+  if (l+1==h.levels.size()) {
+    if (!h.lu.empty()) {
+      std::copy(L.b.begin(),L.b.end(),L.x.begin());
+      lu_solve(n,h.lu,h.piv,&L.x[0]);
+    }
+    else {
+      smooth(L,h.par,true);
+      smooth(L,h.par,false);
+    }
+    return;
+  }
+
+  // pre-smoothing, and residual restricted to the coarser level
+  smooth(L,h.par,true);
+  #pragma omp parallel for schedule(static)
+  for (int i=0; i<n; ++i) {
+    double s = L.b[i];
+    for (int k=L.ia[i]; k<L.ia[i+1]; ++k)
+      s -= L.a[k]*L.x[L.ja[k]];
+    L.r[i] = s;
+  }
+  level_t& C = h.levels[l+1];
+  #pragma omp parallel for schedule(static)
+  for (int i=0; i<C.n; ++i) {
+    double s = 0.;
+    for (int k=L.ria[i]; k<L.ria[i+1]; ++k)
+      s += L.ra[k]*L.r[L.rja[k]];
+    C.b[i] = s;
+  }
+
+  // coarser level correction, prolongated, and post-smoothing
+  vcycle(h,l+1);
+  #pragma omp parallel for schedule(static)
+  for (int i=0; i<n; ++i) {
+    double s = 0.;
+    for (int k=L.pia[i]; k<L.pia[i+1]; ++k)
+      s += L.pa[k]*C.x[L.pja[k]];
+    L.x[i] += s;
+  }
+  smooth(L,h.par,false);
+}
+
+
+void AMG::smooth(level_t& L, const parameters_t& par, const bool& forward)
+{
+  const int n = L.n;
+  if (par.smoother=="gs") {
+
+    // Gauss-Seidel, forward (pre-) and backward (post-smoothing) for a
+    // symmetric V-cycle
+    for (int s=0; s<par.sweeps; ++s)
+      for (int j=0; j<n; ++j) {
+        const int i = (forward? j : n-1-j);
+        double r = L.b[i];
+        for (int k=L.ia[i]; k<L.ia[i+1]; ++k)
+          r -= L.a[k]*L.x[L.ja[k]];
+        L.x[i] += L.dinv[i]*r;
+      }
+  }
+  else {
+
+    // weighted Jacobi, x += omega D^-1 (b - A x)
+    for (int s=0; s<par.sweeps; ++s) {
+      #pragma omp parallel for schedule(static)
+      for (int i=0; i<n; ++i) {
+        double r = L.b[i];
+        for (int k=L.ia[i]; k<L.ia[i+1]; ++k)
+          r -= L.a[k]*L.x[L.ja[k]];
+        L.r[i] = r;
+      }
+      #pragma omp parallel for schedule(static)
+      for (int i=0; i<n; ++i)
+        L.x[i] += L.omega*L.dinv[i]*L.r[i];
+    }
+  }
+}
+
+
+}  // namespace lss
+}  // namespace cf3
@@ -0,0 +1,133 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#ifndef cf3_lss_AMG_hpp
+#define cf3_lss_AMG_hpp
+
+
+#include "LibLSS.hpp"
+#include "detail_solverbase.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+/**
+ * implementation of a smoothed aggregation algebraic multigrid linear system
+ * solver by V-cycles, for elliptic-dominated systems; the multigrid hierarchy
+ * is also used as preconditioner by other solvers (double p.)
+ */
+class lss_API AMG : public detail::solverbase
+{
+ public:
+  // framework interfacing
+  static std::string type_name();
+
+  /// Construction
+  AMG(const std::string& name,
+      const size_t& _size_i=size_t(),
+      const size_t& _size_j=size_t(),
+      const size_t& _size_k=1 );
+
+  /// Linear system solving: x = A^-1 b
+  AMG& solve();
+
+  /// Linear system copy
+  AMG& copy(const AMG& _other);
+
+  /// Linear system swap
+  AMG& swap(AMG& _other);
+
+
+ public:
+  // multigrid functions (reentrant, any state is kept in the hierarchy),
+  // also used by other solvers as preconditioner
+
+  /// Multigrid parameters: strength of connection threshold (theta), largest
+  /// coarsest level size solved directly (coarse), maximum number of levels,
+  /// smoother ("jacobi" or "gs", Gauss-Seidel) and its number of sweeps
+  struct parameters_t {
+    parameters_t() : theta(0.08), coarse(100), maxlevels(20), smoother("gs"), sweeps(1) {}
+    double      theta;
+    int         coarse;
+    int         maxlevels;
+    std::string smoother;
+    int         sweeps;
+  };
+
+  /// Multigrid level: operator (ia, ja, a, 0-based), inverse diagonal (dinv)
+  /// and Jacobi weight (omega), prolongation from the next coarser level
+  /// (pia, pja, pa) and restriction to it (ria, rja, ra), and solution (x),
+  /// right-hand side (b) and residual (r) work vectors
+  struct level_t {
+    level_t() : n(0), omega(0.) {}
+    int n;
+    std::vector< double > a, dinv, pa, ra, x, b, r;
+    std::vector< int > ia, ja, pia, pja, ria, rja;
+    double omega;
+  };
+
+  /// Multigrid hierarchy: levels (finest first), coarsest level dense LU
+  /// factor (lu, piv, if solved directly) and parameters used
+  struct hierarchy_t {
+    hierarchy_t() : pattern(0), age(0) {}
+    std::vector< level_t > levels;
+    std::vector< double > lu;
+    std::vector< int > piv;
+    parameters_t par;
+    size_t pattern;  // matrix structure version of hierarchy
+    int    age;      // ... and number of solves since calculated
+  };
+
+  /// Multigrid hierarchy (re)calculation: recalculated when the matrix
+  /// structure version or parameters change and every given number of solves
+  /// (0 for only with the structure); returns 0 or error code
+  static int setup(const matrix_t::matrix_compressed_t& A, const size_t& pattern, const int& refresh, const parameters_t& par, hierarchy_t& h);
+
+  /// Multigrid hierarchy error description
+  static std::string setup_message(const int& err);
+
+  /// Multigrid V-cycle, x = M^-1 b with a zero initial guess (in place if x
+  /// and b are the same)
+  static void vcycle(hierarchy_t& h, const double* b, double* x);
+
+  /// Multigrid operator complexity, sum of all levels number of nonzeros over
+  /// the finest level's
+  static double complexity(const hierarchy_t& h);
+
+
+ private:
+  // internal functions
+
+  /// Multigrid V-cycle from given level, on the level work vectors
+  static void vcycle(hierarchy_t& h, const size_t& l);
+
+  /// Multigrid level smoothing, forward or backward (Gauss-Seidel only)
+  static void smooth(level_t& L, const parameters_t& par, const bool& forward);
+
+
+ protected:
+  // options
+  double       m_rtol;        // relative residual reduction tolerance
+  int          m_maxits;      // maximum number of iterations (V-cycles)
+  parameters_t m_par;         // multigrid parameters
+  bool         m_monitor;     // if each iteration should be printed
+  int          m_pc_refresh;  // multigrid hierarchy recalculation period (solves)
+
+  // storage (kept between solves): multigrid hierarchy (residual and
+  // correction vectors are the work vectors)
+  hierarchy_t m_h;
+
+};
+
+
+}  // namespace lss
+}  // namespace cf3
+
+
+#endif
@@ -0,0 +1,137 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#include <cmath>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "BiCGStab.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+std::string BiCGStab::type_name() { return "BiCGStab"; }
+common::ComponentBuilder< BiCGStab, common::Component, LibLSS > Builder_BiCGStab;
+
+
+BiCGStab::BiCGStab(const std::string& name, const size_t& _size_i, const size_t& _size_j, const size_t& _size_k)
+  : detail::ilu_solverbase(name)
+{
+  linearsystem< double >::initialize(_size_i,_size_j,_size_k);
+}
+
+
+BiCGStab& BiCGStab::solve()
+{
+  if (!m_A.m_size.is_square_size())
+    throw std::runtime_error("BiCGStab: system matrix must be square.");
+  matrix_t::matrix_compressed_t& A = m_A.compress();
+
+  int err = 0;
+  if ((err=precondition_setup(A)))
+    throw std::runtime_error("BiCGStab: " + GMRES::ilu_message(err));
+
+  // solve each right-hand side, with workspace vectors (right preconditioned)
+  int n = static_cast< int >(size(0));
+  m_work.resize(8*n);
+  double
+    *r  = &m_work[0],   *rt = &m_work[n],   *p  = &m_work[2*n], *v = &m_work[3*n],
+    *ph = &m_work[4*n], *s  = &m_work[5*n], *sh = &m_work[6*n], *t = &m_work[7*n];
+  int itsmax = 0;
+  double resmax = 0.;
+  bool converged = true;
+  for (size_t k=0; k<size(2); ++k) {
+    double *x = &m_x.a[k*n], *b = &m_b.a[k*n];
+
+    // initial residual r = b - A x, and shadow residual r~ = r
+    m_A.multi(x,r,1,-1.);
+    for (int i=0; i<n; ++i)
+      r[i] += b[i];
+    std::copy(r,r+n,rt);
+    double
+      res = std::sqrt(dot(n,r,r)),
+      eps = m_rtol*res,
+      rho = 1., alpha = 1., omega = 1.;
+    int its = 0;
+
+    while (res>eps && its<m_maxits) {
+      ++its;
+
+      // search direction p = r + beta (p - omega v), and v = A M^-1 p
+      const double rho1 = dot(n,rt,r);
+      if (rho1==0.)
+        throw std::runtime_error("BiCGStab: breakdown (r~'r = 0), restart with a different initial guess.");
+      const double beta = (rho1/rho)*(alpha/omega);
+      #pragma omp parallel for schedule(static)
+      for (int i=0; i<n; ++i)
+        p[i] = (its==1? r[i] : r[i] + beta*(p[i] - omega*v[i]));
+      precondition(n,p,ph);
+      m_A.multi(ph,v,1);
+
+      // half step s = r - alpha v, finishing if converged already
+      const double rtv = dot(n,rt,v);
+      if (rtv==0.)
+        throw std::runtime_error("BiCGStab: breakdown (r~'v = 0), restart with a different initial guess.");
+      alpha = rho1/rtv;
+      #pragma omp parallel for schedule(static)
+      for (int i=0; i<n; ++i)
+        s[i] = r[i] - alpha*v[i];
+      const double snorm = std::sqrt(dot(n,s,s));
+      if (snorm<=eps) {
+        #pragma omp parallel for schedule(static)
+        for (int i=0; i<n; ++i)
+          x[i] += alpha*ph[i];
+        res = snorm;
+      }
+      else {
+
+        // stabilizing step, minimizing ||s - omega t|| with t = A M^-1 s
+        precondition(n,s,sh);
+        m_A.multi(sh,t,1);
+        const double tt = dot(n,t,t);
+        omega = (tt>0.? dot(n,t,s)/tt : 0.);
+        if (omega==0.)
+          throw std::runtime_error("BiCGStab: breakdown (omega = 0), restart with a different initial guess.");
+        double rr = 0.;
+        #pragma omp parallel for schedule(static) reduction(+:rr)
+        for (int i=0; i<n; ++i) {
+          x[i] += alpha*ph[i] + omega*sh[i];
+          r[i]  = s[i] - omega*t[i];
+          rr += r[i]*r[i];
+        }
+        res = std::sqrt(rr);
+        rho = rho1;
+      }
+
+      if (m_monitor) {
+        CFinfo << "BiCGStab: iteration/residual: " << its << '/' << res;
+        if (size(2)>1)
+          CFinfo << " (rhs " << k << ')';
+        CFinfo << CFendl;
+      }
+    }
+
+    itsmax = std::max(itsmax,its);
+    resmax = std::max(resmax,res);
+    converged = converged && res<=eps;
+  }
+
+  properties()["iterations"] = itsmax;
+  properties()["residual"]   = resmax;
+  if (m_monitor)
+    CFinfo << "BiCGStab: iterations/residual: " << itsmax << '/' << resmax << CFendl;
+  if (!converged)
+    throw std::runtime_error("BiCGStab: convergence not achieved in maxits iterations.");
+
+  return *this;
+}
+
+
+}  // namespace lss
+}  // namespace cf3
@@ -0,0 +1,47 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#ifndef cf3_lss_BiCGStab_hpp
+#define cf3_lss_BiCGStab_hpp
+
+
+#include "LibLSS.hpp"
+#include "detail_ilu_solverbase.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+/**
+ * implementation of a right ILU(k)-preconditioned BiCGStab linear system
+ * solver, with memory independent of the number of iterations (8 work vectors,
+ * double p.)
+ */
+class lss_API BiCGStab : public detail::ilu_solverbase
+{
+ public:
+  // framework interfacing
+  static std::string type_name();
+
+  /// Construction
+  BiCGStab(const std::string& name,
+           const size_t& _size_i=size_t(),
+           const size_t& _size_j=size_t(),
+           const size_t& _size_k=1 );
+
+  /// Linear system solving: x = A^-1 b
+  BiCGStab& solve();
+
+};
+
+
+}  // namespace lss
+}  // namespace cf3
+
+
+#endif
@@ -0,0 +1,267 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#include <cmath>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "CG.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+std::string CG::type_name() { return "CG"; }
+common::ComponentBuilder< CG, common::Component, LibLSS > Builder_CG;
+
+
+CG::CG(const std::string& name, const size_t& _size_i, const size_t& _size_j, const size_t& _size_k)
+  : detail::solverbase(name)
+{
+  // framework scripting: options
+  m_rtol    = 1.e-5;
+  m_maxits  = 1000;
+  m_pc_type = "jacobi";
+  m_omega   = 1.;
+  m_monitor = false;
+  options().add("rtol",    m_rtol   ).link_to(&m_rtol   ).mark_basic().description("relative tolerance, solving stops when ||residual||/||initial residual|| <= rtol (default 1.e-5)");
+  options().add("maxits",  m_maxits ).link_to(&m_maxits ).mark_basic().description("maximum number of iterations to perform (default 1000)");
+  options().add("PCType",  m_pc_type).link_to(&m_pc_type).mark_basic().description("preconditioner type, \"none\", \"jacobi\" (default), \"ic0\" or \"ssor\"");
+  options().add("omega",   m_omega  ).link_to(&m_omega  ).mark_basic().description("ssor only: relaxation factor, in ]0,2[ (default 1, symmetric Gauss-Seidel)");
+  options().add("monitor", m_monitor).link_to(&m_monitor).mark_basic().description("if each iteration should be printed (default false)");
+
+  linearsystem< double >::initialize(_size_i,_size_j,_size_k);
+}
+
+
+CG& CG::solve()
+{
+  if (!m_A.m_size.is_square_size())
+    throw std::runtime_error("CG: system matrix must be square.");
+  matrix_t::matrix_compressed_t& A = m_A.compress();
+
+  const int n = static_cast< int >(size(0));
+  precondition_setup(A);
+
+  // solve each right-hand side, with workspace vectors r, z, p and q
+  m_work.resize(4*n);
+  double *r = &m_work[0], *z = &m_work[n], *p = &m_work[2*n], *q = &m_work[3*n];
+  int itsmax = 0;
+  double resmax = 0.;
+  bool converged = true;
+  for (size_t k=0; k<size(2); ++k) {
+    double *x = &m_x.a[k*n], *b = &m_b.a[k*n];
+
+    // initial residual r = b - A x, and search direction p = z = M^-1 r
+    m_A.multi(x,r,1,-1.);
+    for (int i=0; i<n; ++i)
+      r[i] += b[i];
+    double
+      res  = std::sqrt(dot(n,r,r)),
+      eps  = m_rtol*res;
+    int its = 0;
+    if (res>0.) {
+      precondition(A,r,z);
+      std::copy(z,z+n,p);
+      double rz = dot(n,r,z);
+
+      while (res>eps && its<m_maxits) {
+        ++its;
+
+        // step along search direction, updating solution and residual
+        m_A.multi(p,q,1);
+        const double pq = dot(n,p,q);
+        if (!(pq>0.))
+          throw std::runtime_error("CG: system matrix is not positive definite (p'Ap <= 0).");
+        const double alpha = rz/pq;
+        double rr = 0.;
+        #pragma omp parallel for schedule(static) reduction(+:rr)
+        for (int i=0; i<n; ++i) {
+          x[i] += alpha*p[i];
+          r[i] -= alpha*q[i];
+          rr += r[i]*r[i];
+        }
+        res = std::sqrt(rr);
+        if (m_monitor) {
+          CFinfo << "CG: iteration/residual: " << its << '/' << res;
+          if (size(2)>1)
+            CFinfo << " (rhs " << k << ')';
+          CFinfo << CFendl;
+        }
+        if (res<=eps)
+          break;
+
+        // new (conjugate) search direction
+        precondition(A,r,z);
+        const double rzold = rz;
+        rz = dot(n,r,z);
+        const double beta = rz/rzold;
+        #pragma omp parallel for schedule(static)
+        for (int i=0; i<n; ++i)
+          p[i] = z[i] + beta*p[i];
+      }
+    }
+
+    itsmax = std::max(itsmax,its);
+    resmax = std::max(resmax,res);
+    converged = converged && res<=eps;
+  }
+
+  properties()["iterations"] = itsmax;
+  properties()["residual"]   = resmax;
+  if (m_monitor)
+    CFinfo << "CG: iterations/residual: " << itsmax << '/' << resmax << CFendl;
+  if (!converged)
+    throw std::runtime_error("CG: convergence not achieved in maxits iterations.");
+
+  return *this;
+}
+
+
+CG& CG::copy(const CG& _other)
+{
+  detail::solverbase::copy(_other);
+  m_rtol    = _other.m_rtol;
+  m_maxits  = _other.m_maxits;
+  m_pc_type = _other.m_pc_type;
+  m_omega   = _other.m_omega;
+  m_monitor = _other.m_monitor;
+  m_ws = workspace_t();
+  return *this;
+}
+
+
+CG& CG::swap(CG& _other)
+{
+  detail::solverbase::swap(_other);
+  m_ws = _other.m_ws = workspace_t();
+  return *this;
+}
+
+
+void CG::precondition_setup(const matrix_t::matrix_compressed_t& A)
+{
+  const int n = A.nnu;
+  workspace_t& ws = m_ws;
+  if (m_pc_type=="none")
+    return;
+  if (m_pc_type!="jacobi" && m_pc_type!="ic0" && m_pc_type!="ssor")
+    throw std::runtime_error("CG: unknown preconditioner type \"" + m_pc_type + "\".");
+  if (m_pc_type=="ssor" && !(m_omega>0. && m_omega<2.))
+    throw std::runtime_error("CG: ssor relaxation factor (omega) should be in ]0,2[.");
+
+  // diagonal positions and inverse (Jacobi and SSOR), positive if SPD
+  ws.diag.assign(n,-1);
+  ws.dinv.assign(n,0.);
+  for (int i=0; i<n; ++i) {
+    for (int k=A.ia[i]-1; k<A.ia[i+1]-1; ++k)
+      if (A.ja[k]-1==i)
+        ws.diag[i] = k;
+    if (ws.diag[i]<0 || !(A.a[ws.diag[i]]>0.)) {
+      std::ostringstream msg;
+      msg << "CG: non-positive diagonal entry at row " << i << " (system matrix is not positive definite).";
+      throw std::runtime_error(msg.str());
+    }
+    ws.dinv[i] = 1./A.a[ws.diag[i]];
+  }
+  if (m_pc_type!="ic0")
+    return;
+
+  // IC(0) factor structure: strictly lower triangular part of the matrix
+  // (0-based, with sorted columns), kept while the matrix structure is unchanged
+  if (ws.pattern!=m_A.pattern_version()) {
+    ws.lia.assign(1,0);
+    ws.lja.clear();
+    for (int i=0; i<n; ++i) {
+      for (int k=A.ia[i]-1; k<ws.diag[i]; ++k)
+        ws.lja.push_back(A.ja[k]-1);
+      ws.lia.push_back(static_cast< int >(ws.lja.size()));
+    }
+    ws.la.resize(ws.lja.size());
+    ws.pattern = m_A.pattern_version();
+  }
+
+  // IC(0) factor values, row by row: L(i,j) = (A(i,j) - sum_m L(i,m) L(j,m))/L(j,j),
+  // for m<j (merging rows i and j), and inverse diagonal 1/L(i,i)
+  for (int i=0; i<n; ++i) {
+    double d = A.a[ws.diag[i]];
+    for (int k=ws.lia[i], ka=A.ia[i]-1; k<ws.lia[i+1]; ++k, ++ka) {
+      const int j = ws.lja[k];
+      double s = A.a[ka];
+      for (int m=ws.lia[i], mj=ws.lia[j]; m<k && mj<ws.lia[j+1];) {
+        if      (ws.lja[m]<ws.lja[mj]) ++m;
+        else if (ws.lja[m]>ws.lja[mj]) ++mj;
+        else    s -= ws.la[m++]*ws.la[mj++];
+      }
+      ws.la[k] = s*ws.dinv[j];
+      d -= ws.la[k]*ws.la[k];
+    }
+    if (!(d>0.)) {
+      ws.pattern = 0;
+      std::ostringstream msg;
+      msg << "CG: IC(0) breakdown, non-positive pivot at row " << i << " (try PCType \"jacobi\" or \"ssor\").";
+      throw std::runtime_error(msg.str());
+    }
+    ws.dinv[i] = 1./std::sqrt(d);
+  }
+}
+
+
+void CG::precondition(const matrix_t::matrix_compressed_t& A, const double* r, double* z) const
+{
+  const int n = A.nnu;
+  const workspace_t& ws = m_ws;
+
+  if (m_pc_type=="jacobi") {
+    #pragma omp parallel for schedule(static)
+    for (int i=0; i<n; ++i)
+      z[i] = ws.dinv[i]*r[i];
+  }
+  else if (m_pc_type=="ssor") {
+
+    // forward (D/omega+L) y = r, then backward (D/omega+U) z = D/omega y,
+    // scaled by (2-omega)
+    for (int i=0; i<n; ++i) {
+      double s = r[i];
+      for (int k=A.ia[i]-1; k<ws.diag[i]; ++k)
+        s -= A.a[k]*z[A.ja[k]-1];
+      z[i] = m_omega*s*ws.dinv[i];
+    }
+    for (int i=n-1; i>=0; --i) {
+      double s = 0.;
+      for (int k=ws.diag[i]+1; k<A.ia[i+1]-1; ++k)
+        s += A.a[k]*z[A.ja[k]-1];
+      z[i] -= m_omega*s*ws.dinv[i];
+    }
+    const double scale = 2.-m_omega;
+    for (int i=0; i<n; ++i)
+      z[i] *= scale;
+  }
+  else if (m_pc_type=="ic0") {
+
+    // forward L y = r, then backward L' z = y (in place)
+    for (int i=0; i<n; ++i) {
+      double s = r[i];
+      for (int k=ws.lia[i]; k<ws.lia[i+1]; ++k)
+        s -= ws.la[k]*z[ws.lja[k]];
+      z[i] = s*ws.dinv[i];
+    }
+    for (int i=n-1; i>=0; --i) {
+      z[i] *= ws.dinv[i];
+      for (int k=ws.lia[i]; k<ws.lia[i+1]; ++k)
+        z[ws.lja[k]] -= ws.la[k]*z[i];
+    }
+  }
+  else {
+    std::copy(r,r+n,z);
+  }
+}
+
+
+}  // namespace lss
+}  // namespace cf3
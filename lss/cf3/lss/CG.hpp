@@ -0,0 +1,86 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#ifndef cf3_lss_CG_hpp
+#define cf3_lss_CG_hpp
+
+
+#include "LibLSS.hpp"
+#include "detail_solverbase.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+/**
+ * implementation of a preconditioned Conjugate Gradient linear system solver,
+ * for symmetric positive definite systems (double p.)
+ */
+class lss_API CG : public detail::solverbase
+{
+ public:
+  // framework interfacing
+  static std::string type_name();
+
+  /// Construction
+  CG(const std::string& name,
+     const size_t& _size_i=size_t(),
+     const size_t& _size_j=size_t(),
+     const size_t& _size_k=1 );
+
+  /// Linear system solving: x = A^-1 b
+  CG& solve();
+
+  /// Linear system copy
+  CG& copy(const CG& _other);
+
+  /// Linear system swap
+  CG& swap(CG& _other);
+
+
+ private:
+  // internal functions
+
+  /// Preconditioner workspace: diagonal positions (diag) and inverse (dinv)
+  /// for Jacobi and SSOR, or the lower triangular IC(0) factor (lia, lja, la)
+  /// with inverse diagonal
+  struct workspace_t {
+    workspace_t() : pattern(0) {}
+    std::vector< double > dinv, la;
+    std::vector< int > diag, lia, lja;
+    size_t pattern;  // matrix structure version of IC(0) factor structure
+  };
+
+  /// Preconditioner calculation
+  void precondition_setup(const matrix_t::matrix_compressed_t& A);
+
+  /// Preconditioner application, z = M^-1 r
+  void precondition(const matrix_t::matrix_compressed_t& A, const double* r, double* z) const;
+
+
+ protected:
+  // options
+  double      m_rtol;     // relative residual reduction tolerance
+  int         m_maxits;   // maximum number of iterations
+  std::string m_pc_type;  // preconditioner type
+  double      m_omega;    // SSOR relaxation factor
+  bool        m_monitor;  // if each iteration should be printed
+
+  // storage (kept between solves): preconditioner (residual, preconditioned
+  // residual, search direction and its product with the matrix are the work
+  // vectors)
+  workspace_t m_ws;
+
+};
+
+
+}  // namespace lss
+}  // namespace cf3
+
+
+#endif
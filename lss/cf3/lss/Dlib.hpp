@@ -9,6 +9,7 @@
 #define cf3_lss_Dlib_hpp
 
 
+#include "boost/shared_ptr.hpp"
 #include "dlib/assert.h"
 #include "dlib/matrix.h"
 
@@ -123,6 +124,7 @@ class lss_API Dlib : public linearsystem< T >
 {
   // utility definitions
   typedef detail::dense_matrix_dlib< T > matrix_t;
+  typedef dlib::lu_decomposition< dlib::matrix< T > > lu_t;
 
 
   // framework interfacing
@@ -139,23 +141,39 @@ class lss_API Dlib : public linearsystem< T >
 
   /// Linear system solving: x = A^-1 b
   Dlib& solve() {
+    return factorize().solve_only();
+  }
 
-    //dlib::matrix<double,0,1> dlib_x = dlib::inv(m_A.a) * dlib::vector_to_matrix(m_B);
-    //for (unsigned i=0; i<Nb*Ne; ++i)
-    //  m_X[i] = dlib_x(i);
-
-
-    // extremely innefficient but elegant, like a pig with lipstick...
-    dlib::matrix< T > rhs(linearsystem< T >::size(0),linearsystem< T >::size(2));
-    for (size_t i=0; i<linearsystem< T >::size(1); ++i)
-      for (size_t j=0; j<linearsystem< T >::size(2); ++j)
-        rhs(i,j) = linearsystem< T >::b(i,j);
-
-    dlib::matrix< T > sol = dlib::inv(m_A.a) * rhs;
+  /// Linear system matrix factorization (LU, kept apart so A is preserved)
+  Dlib& factorize() {
+    if (!m_A.m_size.is_square_size())
+      throw std::runtime_error("Dlib: system matrix must be square.");
+    m_LU.reset(new lu_t(m_A.a));
+    if (m_LU->is_singular()) {
+      m_LU.reset();
+      throw std::runtime_error("Dlib: system matrix is singular (not invertible).");
+    }
+    return *this;
+  }
 
-    for (size_t i=0; i<linearsystem< T >::size(1); ++i)
-      for (size_t j=0; j<linearsystem< T >::size(2); ++j)
-        linearsystem< T >::x(i,j) = sol(i,j);
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  Dlib& solve_only() {
+    const long
+      N(static_cast< long >(this->size(0))),
+      K(static_cast< long >(this->size(2)));
+    if (!m_LU || m_LU->nr()!=N)
+      factorize();
+
+    // b is wrapped (column-major storage, seen as its row-major transpose)
+    // and the solution is copied directly into x storage
+    const dlib::matrix< T > sol = m_LU->solve(dlib::trans(dlib::mat(&this->m_b.a[0],K,N)));
+    T* x = &this->m_x.a[0];
+    if (K==1)
+      std::copy(&sol(0,0),&sol(0,0)+N,x);
+    else
+      for (long k=0; k<K; ++k)
+        for (long i=0; i<N; ++i)
+          x[k*N+i] = sol(i,k);
     return *this;
   }
 
@@ -178,7 +196,8 @@ class lss_API Dlib : public linearsystem< T >
   /// Linear system copy
   Dlib& copy(const Dlib& _other) {
     linearsystem< T >::copy(_other);
-    m_A = _other.m_A;
+    m_A  = _other.m_A;
+    m_LU = _other.m_LU;  // (shared, it is not modified by solving)
     return *this;
   }
 
@@ -187,6 +206,7 @@ class lss_API Dlib : public linearsystem< T >
   {
     linearsystem< T >::swap(_other);
     m_A.swap(_other.m_A);
+    m_LU.swap(_other.m_LU);
     return *this;
   }
 
@@ -199,11 +219,11 @@ class lss_API Dlib : public linearsystem< T >
         T& A(const size_t& i, const size_t& j)       { return m_A(i,j); }
 
   /// matrix modifiers
-  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j); }
-  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); }
-  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  }
+  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j); m_LU.reset(); }
+  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); m_LU.reset(); }
+  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  m_LU.reset(); }
   void A___assign(const double& _value)                 { m_A.operator=(_value); }
-  void A___clear()                                      { m_A.clear();           }
+  void A___clear()                                      { m_A.clear();           m_LU.reset(); }
   void A___zerorow(const size_t& i)                     { m_A.zerorow(i);        }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc);   }
 
@@ -215,6 +235,7 @@ class lss_API Dlib : public linearsystem< T >
  protected:
   // storage
   matrix_t m_A;
+  boost::shared_ptr< lu_t > m_LU;  // LU factorization (A is left intact)
 
 };
 
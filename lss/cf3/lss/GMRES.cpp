@@ -8,6 +8,7 @@
 #include <cmath>
 
 #include "common/Builder.hpp"
+#include "common/Log.hpp"
 #include "GMRES.hpp"
 
 
@@ -19,66 +20,84 @@ std::string GMRES::type_name() { return "GMRES"; }
 common::ComponentBuilder< GMRES, common::Component, LibLSS > Builder_GMRES;
 
 
+GMRES::GMRES(const std::string& name, const size_t& _size_i, const size_t& _size_j, const size_t& _size_k)
+  : linearsystem< double >(name)
+{
+  // framework scripting: options and properties
+  m_rtol    = 1.e-5;
+  m_restart = 50;
+  m_maxits  = 50;
+  m_lfil    = 3;
+  m_monitor = false;
+  m_pc_refresh = 1;
+  m_level_scheduling = false;
+  m_pc_type = "ilu";
+  options().add("rtol",    m_rtol   ).link_to(&m_rtol   ).mark_basic().description("relative tolerance, solving stops when ||residual||/||initial residual|| <= rtol (default 1.e-5)");
+  options().add("restart", m_restart).link_to(&m_restart).mark_basic().description("number of non-restarted iterations, the Krylov subspace size (default 50, minimum 2)");
+  options().add("maxits",  m_maxits ).link_to(&m_maxits ).mark_basic().description("maximum number of iterations to perform (default 50)");
+  options().add("lfil",    m_lfil   ).link_to(&m_lfil   ).mark_basic().description("ILU(k) preconditioner level of fill, 0 for ILU(0) (default 3)");
+  options().add("monitor", m_monitor).link_to(&m_monitor).mark_basic().description("if each iteration should be printed (default false)");
+  options().add("PCRefresh", m_pc_refresh).link_to(&m_pc_refresh).mark_basic().description("recalculate preconditioner values every given number of solves, 0 for only when the matrix structure changes (default 1)");
+  options().add("LevelScheduling", m_level_scheduling).link_to(&m_level_scheduling).mark_basic().description("if preconditioner recalculation and application run in parallel, by levels of L and U factors rows (same results, default false)");
+  options().add("PCType",  m_pc_type).link_to(&m_pc_type).mark_basic().description("preconditioner type, \"ilu\" (ILU(k), default) or \"amg\" (smoothed aggregation algebraic multigrid V-cycle, for elliptic-dominated systems)");
+
+  properties().add("iterations",int(0));
+  properties().add("residual",  double(0.));
+
+  linearsystem< double >::initialize(_size_i,_size_j,_size_k);
+}
+
+
 GMRES& GMRES::solve()
 {
   matrix_t::matrix_compressed_t& A = m_A.compress();
 
   int n = static_cast< int >(size(0));
   int err;
-  int iwk = A.nnz;
-  double eps = 1e-5;  // tolerance, process is stopped when eps>=||current residual||/||initial residual||
-  int im     = 50;    // size of krylov subspace (should not exceed 50)
-  int maxits = 50;    // maximum number of iterations allowed
-  int iout   = 1;
-  int lfil   = 3;
-
-  double *alu = new double[iwk];
-  int *jlu = new int[iwk];
-  for (register int i=0; i<iwk; i++) {
-    alu[i] = 0.;
-    jlu[i] = 0;
+  double eps = m_rtol;     // tolerance, process is stopped when eps>=||current residual||/||initial residual||
+  int im     = m_restart;  // size of krylov subspace
+  int maxits = m_maxits;   // maximum number of iterations allowed
+  int iout   = m_monitor? 1:0;
+  int lfil   = m_lfil;
+  int its    = 0;
+  double res = 0.;
+  if (im<2)
+    throw std::runtime_error("GMRES: restart should be at least 2.");
+
+  // workspace is kept between solves (only resized), per component so that
+  // solving different components concurrently is still reentrant
+  workspace_t& ws = m_ws;
+  if (m_pc_type=="amg") {
+    ws.pattern = 0;
+    if ((err=AMG::setup(A,m_A.pattern_version(),m_pc_refresh,AMG::parameters_t(),ws.amg)))
+      throw std::runtime_error("GMRES: " + AMG::setup_message(err));
+    if (m_monitor)
+      CFinfo << "GMRES: multigrid levels/operator complexity: " << ws.amg.levels.size() << '/' << AMG::complexity(ws.amg) << " (rows: " << n << ")" << CFendl;
   }
-
-  int *ju = new int[n+1];
-  for (register int i=0; i<n; i++)
-    ju[i] = 0;
-
-  double *w = new double[n+1];
-  int *jw = new int[n*3];
-  for (register int i=0; i<n; i++) {
-    w[i] = 0.;
-    jw[i] = 0;
-    jw[n+i] = 0;
-    jw[2*n+i] = 0;
-  }
-
-
-  int *levs = new int[iwk];
-
-  err = 0;
-  int newiwk = 0;
-  newiwk = iluk(&n,&A.a[0],&A.ja[0],&A.ia[0],&lfil,alu,jlu,ju,levs,&iwk,w,jw,&err);
-  if (err) {
-    std::ostringstream msg;
-    msg << "GMRES: iluk error " << err << ": ";
-    err>  0? msg << "zero pivot encountered at step number " << (err-1) << '.' :
-    err==-1? msg << "input matrix may be wrong. the elimination process has generated a row in L or U whose length is .gt. n." :
-    err==-2? msg << "the matrix L overflows the array al." :
-    err==-3? msg << "the matrix U overflows the array alu." :
-    err==-4? msg << "illegal value for lfil." :
-    err==-5? msg << "zero row encountered in A or U." :
-             msg << "unknown error.";
-    throw std::runtime_error(msg.str());
+  else if (m_pc_type=="ilu") {
+    ws.amg = AMG::hierarchy_t();
+    if ((err=ilu(A,m_A.pattern_version(),lfil,m_pc_refresh,m_level_scheduling,ws)))
+      throw std::runtime_error("GMRES: " + ilu_message(err));
+    if (m_monitor && m_level_scheduling)
+      CFinfo << "GMRES: level scheduling L/U levels: " << ws.lptr.size()-1 << '/' << ws.uptr.size()-1 << " (rows: " << n << ")" << CFendl;
   }
+  else
+    throw std::runtime_error("GMRES: unknown preconditioner type \"" + m_pc_type + "\".");
 
-  delete[] levs;
-  delete[] w;
-  delete[] jw;
-
-  double *vv = new double[n*(im+1)];
+  // Krylov workspace, per right-hand side (solved together)
+  int nrhs = static_cast< int >(size(2));
+  ws.vv.resize(n*(im+1)*nrhs);
+  ws.hh.resize((im+1)*im*nrhs);
+  ws.c .resize(im*nrhs);
+  ws.s .resize(im*nrhs);
+  ws.rs.resize((im+1)*nrhs);
 
   err = 0;
-  pgmres(&n,&im,&m_b.a[0],&m_x.a[0],vv,&eps,&maxits,&iout,&A.a[0],&A.ja[0],&A.ia[0],alu,jlu,ju,&err);
+  pgmres(&n,&nrhs,&im,&m_b.a[0],&m_x.a[0],&eps,&maxits,&iout,&A.a[0],&A.ja[0],&A.ia[0],ws,&its,&res,&err);
+  properties()["iterations"] = its;
+  properties()["residual"]   = res;
+  if (m_monitor)
+    CFinfo << "GMRES: iterations/residual: " << its << '/' << res << CFendl;
   if (err) {
     std::ostringstream msg;
     msg << "GMRES: pgmres error " << err << ": ";
@@ -88,25 +107,82 @@ GMRES& GMRES::solve()
     throw std::runtime_error(msg.str());
   }
 
-  delete [] vv;
-  delete [] alu;
-  delete [] jlu;
-  delete [] ju;
-
   return *this;
 }
 
 
-GMRES& GMRES::multi(const double& _alpha, const double& _beta)
+int GMRES::ilu(matrix_t::matrix_compressed_t& A, const size_t& pattern, const int& _lfil, const int& refresh, const bool& level_scheduling, workspace_t& ws)
 {
-  matrix_t::matrix_compressed_t& A = m_A.compress();
-  for (size_t i=0; i<size(0); ++i) {
-    for (size_t k=0; k<size(2); ++k) {
-      b(i,k) *= _beta;
-      for (size_t l=A.ia[i]-A.ia[0]; l<A.ia[i+1]-A.ia[0]; ++l)
-        b(i,k) += _alpha*A.a[l]*m_x( A.ja[l]-A.ia[0], k);
+  int n    = A.nnu;
+  int iwk  = A.nnz;
+  int lfil = _lfil;
+  int err  = 0;
+  ws.ju.resize(n+1);
+  ws.w .resize(n+1);
+  ws.jw.resize(n*3);
+
+  // preconditioner: ILU(k) structure (levels of fill) is kept while matrix
+  // structure and level are unchanged, only values are recalculated
+  const bool
+    symbolic = (ws.pattern!=pattern || ws.lfil!=lfil),
+    numeric  = symbolic || (refresh>0 && ws.age>=refresh);
+
+  // (with level scheduling, values are recalculated in parallel by levels)
+  bool structure = symbolic;
+  if (numeric && !symbolic) {
+    if (level_scheduling && !ws.lrow.empty()) {
+      int nlev = static_cast< int >(ws.lptr.size())-1;
+      ilunum(&n,&A.a[0],&A.ja[0],&A.ia[0],&ws.alu[0],&ws.jlu[0],&ws.ju[0],&nlev,&ws.lptr[0],&ws.lrow[0],&err);
     }
+    else
+      ilunum(&n,&A.a[0],&A.ja[0],&A.ia[0],&ws.alu[0],&ws.jlu[0],&ws.ju[0],&ws.jw[0],&err);
+    if (err==-6) {
+      err = 0;
+      structure = true;
+      iluk(&n,&A.a[0],&A.ja[0],&A.ia[0],&lfil,ws.alu,ws.jlu,&ws.ju[0],&iwk,&ws.w[0],&ws.jw[0],&err);
+    }
+  }
+  else if (numeric) {
+    iluk(&n,&A.a[0],&A.ja[0],&A.ia[0],&lfil,ws.alu,ws.jlu,&ws.ju[0],&iwk,&ws.w[0],&ws.jw[0],&err);
   }
+  ws.pattern = (err? 0 : pattern);
+  ws.lfil    = lfil;
+  ws.age     = (numeric? 1 : ws.age+1);
+  if (err)
+    return err;
+
+  // level scheduling of the L and U factors, recalculated with their structure
+  if (!level_scheduling) {
+    ws.lptr.clear();
+    ws.lrow.clear();
+    ws.uptr.clear();
+    ws.urow.clear();
+  }
+  else if (structure || ws.lrow.empty()) {
+    levels(&n,&ws.jlu[0],&ws.ju[0],ws.lptr,ws.lrow,ws.uptr,ws.urow);
+  }
+  return 0;
+}
+
+
+std::string GMRES::ilu_message(const int& err)
+{
+  std::ostringstream msg;
+  msg << "iluk error " << err << ": ";
+  err>  0? msg << "zero pivot encountered at step number " << (err-1) << '.' :
+  err==-1? msg << "input matrix may be wrong. the elimination process has generated a row in L or U whose length is .gt. n." :
+  err==-2? msg << "the matrix L overflows the array al." :
+  err==-3? msg << "the matrix U overflows the array alu." :
+  err==-4? msg << "illegal value for lfil." :
+  err==-5? msg << "zero row encountered in A or U." :
+           msg << "unknown error.";
+  return msg.str();
+}
+
+
+GMRES& GMRES::multi(const double& _alpha, const double& _beta)
+{
+  m_A.multi(&m_x.a[0],&m_b.a[0],size(2),_alpha,_beta);
   return *this;
 }
 
@@ -114,8 +190,16 @@ GMRES& GMRES::multi(const double& _alpha, const double& _beta)
 GMRES& GMRES::copy(const GMRES& _other)
 {
   linearsystem< double >::copy(_other);
-  m_A  = _other.m_A;
-  c__1 = _other.c__1;
+  m_A = _other.m_A;
+  m_rtol    = _other.m_rtol;
+  m_restart = _other.m_restart;
+  m_maxits  = _other.m_maxits;
+  m_lfil    = _other.m_lfil;
+  m_monitor = _other.m_monitor;
+  m_pc_refresh = _other.m_pc_refresh;
+  m_level_scheduling = _other.m_level_scheduling;
+  m_pc_type = _other.m_pc_type;
+  m_ws = workspace_t();
   return *this;
 }
 
@@ -124,6 +208,7 @@ GMRES& GMRES::swap(GMRES& _other)
 {
   linearsystem< double >::swap(_other);
   m_A.swap(_other.m_A);
+  m_ws = _other.m_ws = workspace_t();
   return *this;
 }
 
@@ -186,16 +271,16 @@ GMRES& GMRES::swap(GMRES& _other)
  * All the diagonal elements of the input matrix must be  nonzero.         *
  *                                                                         *
  *=========================================================================*/
-int GMRES::iluk(int* n, double* a, int* ja, int* ia, int* lfil, double*& aluold, int*& jluold, int* ju, int*& levsold, int* iwk, double* w, int* jw, int* ierr)
+int GMRES::iluk(int* n, double* a, int* ja, int* ia, int* lfil, std::vector< double >& aluout, std::vector< int >& jluout, int* ju, int* iwk, double* w, int* jw, int* ierr)
 {
   /* System generated locals */
   int i__1, i__2, i__3, i__4;
 
   /* Local variables */
-  static double fact;
-  static int lenl, jlev, lenu, jpos, jrow, i__, j, k;
-  static double s, t;
-  static int j1, j2, n2, ii, jj, ju0;
+  double fact;
+  int lenl, jlev, lenu, jpos, jrow, i__, j, k;
+  double s, t;
+  int j1, j2, n2, ii, jj, ju0;
 
   std::vector<double> alu((*iwk)+2,0.);
   std::vector<int> jlu((*iwk)+2,0);
@@ -480,28 +565,8 @@ int GMRES::iluk(int* n, double* a, int* ja, int* ia, int* lfil, double*& aluold,
 /* L500: */
     }
 
-  delete [] aluold;
-  delete [] jluold;
-  //delete [] levsold;
-
-  aluold = new double[*iwk+1];
-  if (aluold == 0)
-    {
-           //cout << "Not enough memory to allocate lu4" << endl;
-    }
-  jluold = new int[*iwk+1];
-  if (jluold == 0)
-    {
-           //cout << "Not enough memory to allocate lu5" << endl;
-    }
-  //levsold = new int[*iwk+1];
-
-  for (int i=0;i<*iwk;++i)
-  {
-    aluold[i] = alu[i+1];
-    jluold[i] = jlu[i+1];
-    //levsold[i] = levs[i+1];
-  }
+  aluout.assign(alu.begin()+1,alu.begin()+1+(*iwk));
+  jluout.assign(jlu.begin()+1,jlu.begin()+1+(*iwk));
 
     *ierr = 0;
   return *iwk;
@@ -537,13 +602,223 @@ L999:
 }
 
 
+/*=========================================================================*
+ *     ILU(K) NUMERICAL FACTORIZATION, ON AN EXISTING ILU(K) STRUCTURE     *
+ *=========================================================================*
+ *                                                                         *
+ * on entry:                                                               *
+ * ==========                                                              *
+ * n       = integer. The row dimension of the matrix A.                   *
+ * a,ja,ia = matrix stored in Compressed Sparse Row format (the non-zero   *
+ *           entries must be within the L and U factors structure).        *
+ * jlu,ju  = L and U factors structure, as computed by iluk (the L part    *
+ *           of each row sorted by column).                                *
+ *                                                                         *
+ * On return:                                                              *
+ * ===========                                                             *
+ * alu     = L and U factors values, in Modified Sparse Row format (same   *
+ *           as iluk, and the same values as if computed by iluk).         *
+ * ierr    = integer. Error message with the following meaning.            *
+ *           ierr  = 0    --> successful return.                           *
+ *           ierr  = -5   --> zero row encountered in A or U.              *
+ *           ierr  = -6   --> non-zero entry of A outside the structure    *
+ *                            (iluk should be called instead).             *
+ *                                                                         *
+ * work arrays:                                                            *
+ * =============                                                           *
+ * iw      = integer work array of length n.                               *
+ *                                                                         *
+ *=========================================================================*/
+void GMRES::ilunum(int* n, double* a, int* ja, int* ia, double* alu, int* jlu, int* ju, int* iw, int* ierr)
+{
+  int i, j;
+
+  *ierr = 0;
+  for (j = 0; j < *n; ++j) {
+    iw[j] = 0;
+  }
+  for (i = 1; i <= *n && !*ierr; ++i) {
+    *ierr = ilurow(i, a - 1, ja - 1, ia - 1, alu - 1, jlu - 1, ju - 1, iw - 1);
+  }
+}
+
+
+/*=========================================================================*
+ *       ILU(K) NUMERICAL FACTORIZATION, LEVEL SCHEDULED (PARALLEL)        *
+ *=========================================================================*
+ *                                                                         *
+ * Same as ilunum, with rows factorized in parallel within each level of   *
+ * L (see levels): a row only depends on rows of previous levels, so the   *
+ * factors are the same as computed by ilunum.                             *
+ *                                                                         *
+ * nlev,                                                                   *
+ * lptr,                                                                   *
+ * lrow    = level scheduling of L: rows lrow(lptr(l):lptr(l+1)-1) are in  *
+ *           level l, for l = 1..nlev.                                     *
+ *                                                                         *
+ * ierr    = -6 if any row has an entry of A outside the structure, else   *
+ *           -5 if any row has a zero pivot, otherwise 0.                  *
+ *                                                                         *
+ * (work arrays are allocated per thread)                                  *
+ *=========================================================================*/
+void GMRES::ilunum(int* n, double* a, int* ja, int* ia, double* alu, int* jlu, int* ju, int* nlev, int* lptr, int* lrow, int* ierr)
+{
+  int err = 0;
+
+  #pragma omp parallel
+  {
+    std::vector< int > iw(*n, 0);
+    int l, r, e, errthread = 0;
+    for (l = 0; l < *nlev; ++l) {
+      #pragma omp for schedule(static)
+      for (r = lptr[l] - 1; r < lptr[l + 1] - 1; ++r) {
+        e = ilurow(lrow[r], a - 1, ja - 1, ia - 1, alu - 1, jlu - 1, ju - 1, &iw[0] - 1);
+        errthread = (errthread == -6 || e == 0 ? errthread : e);
+      }
+    }
+    #pragma omp critical
+    err = (err == -6 ? err : (errthread ? errthread : err));
+  }
+  *ierr = err;
+}
+
+
+/*=========================================================================*
+ * ILU(K) numerical factorization of a single row, i, given the previous   *
+ * rows it depends on (as ilunum, with arrays already adjusted to 1-based  *
+ * indexing). Returns 0, -5 (zero pivot) or -6 (entry of A outside the     *
+ * structure). The work array iw (zero on entry) is zero again on return.  *
+ *=========================================================================*/
+int GMRES::ilurow(int i, double* a, int* ja, int* ia, double* alu, int* jlu, int* ju, int* iw)
+{
+  int k, p, jrow, jpos, ierr = 0;
+  double t;
+
+  /* reset row of L and U, and set positions of its entries */
+  alu[i] = 0.;
+  iw[i] = i;
+  for (k = jlu[i]; k < jlu[i + 1]; ++k) {
+    alu[k] = 0.;
+    iw[jlu[k]] = k;
+  }
+
+  /* unpack row of A */
+  for (k = ia[i]; k < ia[i + 1] && !ierr; ++k) {
+    if (a[k] == 0.) {
+      continue;
+    }
+    if (!iw[ja[k]]) {
+      ierr = -6;
+      break;
+    }
+    alu[iw[ja[k]]] += a[k];
+  }
+
+  /* eliminate previous rows, in increasing column order */
+  for (k = jlu[i]; k < ju[i] && !ierr; ++k) {
+    jrow = jlu[k];
+    t = alu[k] * alu[jrow];
+    alu[k] = t;
+    for (p = ju[jrow]; p < jlu[jrow + 1]; ++p) {
+      jpos = iw[jlu[p]];
+      if (jpos) {
+        alu[jpos] -= t * alu[p];
+      }
+    }
+  }
+
+  /* invert diagonal */
+  if (!ierr && alu[i] == 0.) {
+    ierr = -5;
+  }
+  else if (!ierr) {
+    alu[i] = 1. / alu[i];
+  }
+
+  /* reset positions */
+  iw[i] = 0;
+  for (k = jlu[i]; k < jlu[i + 1]; ++k) {
+    iw[jlu[k]] = 0;
+  }
+  return ierr;
+}
+
+
+/*=========================================================================*
+ *            LEVEL SCHEDULING OF THE L AND U FACTORS (MSR)                *
+ *=========================================================================*
+ *                                                                         *
+ * Computes the dependency levels of the rows of L (forward, row i depends *
+ * on rows j<i with L(i,j) non-zero) and of U (backward, row i depends on  *
+ * rows j>i with U(i,j) non-zero): rows in the same level are independent  *
+ * and can be processed in parallel, one level after the other.            *
+ *                                                                         *
+ * on entry:                                                               *
+ * ==========                                                              *
+ * n       = integer. The row dimension of the matrix.                     *
+ * jlu,ju  = L and U factors structure, as computed by iluk.               *
+ *                                                                         *
+ * on return:                                                              *
+ * ===========                                                             *
+ * lptr,                                                                   *
+ * lrow    = rows per level of L (1-based): rows lrow(lptr(l):lptr(l+1)-1) *
+ *           are in level l, in increasing order.                          *
+ * uptr,                                                                   *
+ * urow    = rows per level of U (1-based), same as above.                 *
+ *                                                                         *
+ *=========================================================================*/
+void GMRES::levels(int* n, int* jlu, int* ju, std::vector< int >& lptr, std::vector< int >& lrow, std::vector< int >& uptr, std::vector< int >& urow)
+{
+  int i, k, l, nlev;
+  std::vector< int > lev(*n + 1, 0);
+
+  /* Parameter adjustments */
+  --jlu;
+  --ju;
+
+  for (int pass = 0; pass < 2; ++pass) {
+    std::vector< int >
+      &ptr(pass ? uptr : lptr),
+      &row(pass ? urow : lrow);
+
+    /* level of each row (1 + maximum level of the rows it depends on) */
+    nlev = 0;
+    for (int ii = 1; ii <= *n; ++ii) {
+      i = (pass ? *n - ii + 1 : ii);
+      l = 0;
+      for (k = (pass ? ju[i] : jlu[i]); k < (pass ? jlu[i + 1] : ju[i]); ++k) {
+        l = std::max(l, lev[jlu[k]]);
+      }
+      lev[i] = l + 1;
+      nlev = std::max(nlev, l + 1);
+    }
+
+    /* rows per level, by counting sort (in increasing row order) */
+    ptr.assign(nlev + 2, 0);
+    for (i = 1; i <= *n; ++i) {
+      ++ptr[lev[i] + 1];
+    }
+    ptr[1] = 1;
+    for (l = 1; l <= nlev; ++l) {
+      ptr[l + 1] += ptr[l];
+    }
+    ptr.erase(ptr.begin());
+    row.resize(*n);
+    std::vector< int > next(ptr);
+    for (i = 1; i <= *n; ++i) {
+      row[next[lev[i] - 1]++ - 1] = i;
+    }
+  }
+}
+
+
 int GMRES::daxpy(int* n, double* da, double* dx, int* incx, double* dy, int* incy)
 {
   /* System generated locals */
   int i__1;
 
   /* Local variables */
-  static int i__, m, ix, iy, mp1;
+  int i__, m, ix, iy, mp1;
 
 
 /*     constant times a vector plus a vector. */
@@ -625,9 +900,9 @@ double GMRES::ddot(int* n, double* dx, int* incx, double* dy, int* incy)
   double ret_val;
 
   /* Local variables */
-  static int i__, m;
-  static double dtemp;
-  static int ix, iy, mp1;
+  int i__, m;
+  double dtemp;
+  int ix, iy, mp1;
 
 
 /*     forms the dot product of two vectors. */
@@ -705,16 +980,10 @@ L60:
 
 double GMRES::dnrm2(int* n, double* dx, int* incx)
 {
-  static double zero = 0.;
-  static double one = 1.;
-  static double cutlo = 8.232e-11;
-  static double cuthi = 1.304e19;
-
-  /* Format strings */
-  static char fmt_30[] = "";
-  static char fmt_50[] = "";
-  static char fmt_70[] = "";
-  static char fmt_110[] = "";
+  const double zero = 0.;
+  const double one = 1.;
+  const double cutlo = 8.232e-11;
+  const double cuthi = 1.304e19;
 
   /* System generated locals */
   int i__1, i__2;
@@ -724,12 +993,9 @@ double GMRES::dnrm2(int* n, double* dx, int* incx)
   //double sqrt();
 
   /* Local variables */
-  static double xmax;
-  static int next, i__, j, nn;
-  static double hitest, sum;
-
-  /* Assigned format variables */
-  static char *next_fmt;
+  double xmax = 0.;
+  int next, i__, j = 1, nn;
+  double hitest, sum;
 
   /* Parameter adjustments */
   --dx;
@@ -750,7 +1016,6 @@ goto L10;
 
 L10:
   next = 0;
-  next_fmt = fmt_30;
   sum = zero;
   nn = *n * *incx;
 /*                                                 begin main loop */
@@ -767,7 +1032,6 @@ L30:
 goto L85;
   }
   next = 1;
-  next_fmt = fmt_50;
   xmax = zero;
 
 /*                        phase 1.  sum is zero */
@@ -782,7 +1046,6 @@ goto L85;
 
 /*                                prepare for phase 2. */
   next = 2;
-  next_fmt = fmt_70;
   goto L105;
 
 /*                                prepare for phase 4. */
@@ -790,7 +1053,6 @@ goto L85;
 L100:
   i__ = j;
   next = 3;
-  next_fmt = fmt_110;
   sum = sum / dx[i__] / dx[i__];
 L105:
   xmax = (d__1 = dx[i__], std::abs(d__1));
@@ -874,8 +1136,8 @@ void GMRES::amux(int* n, double* x, double* y, double* a, int* ja, int* ia)
   int i__1, i__2;
 
   /* Local variables */
-  static int i__, k;
-  static double t;
+  int i__, k;
+  double t;
 
   /* Parameter adjustments */
   --ia;
@@ -902,6 +1164,31 @@ void GMRES::amux(int* n, double* x, double* y, double* a, int* ja, int* ia)
 }
 
 
+void GMRES::amuxm(int* n, int* m, double** x, double** y, double* a, int* ja, int* ia)
+{
+  /* Local variables */
+  int i__, k, l;
+  double t;
+
+  /* Parameter adjustments */
+  --ia;
+  --ja;
+  --a;
+
+  /* Function Body, same as amux for each of the m vectors but sharing the
+     (single) pass over the matrix */
+  for (i__ = 1; i__ <= *n; ++i__) {
+     for (l = 0; l < *m; ++l) {
+        t = 0.;
+        for (k = ia[i__]; k < ia[i__ + 1]; ++k) {
+           t += a[k] * x[l][ja[k] - 1];
+        }
+        y[l][i__ - 1] = t;
+     }
+  }
+}
+
+
 /*=========================================================================*
  *                                                                         *
  * This routine solves the system (LU) x = y,                              *
@@ -929,7 +1216,7 @@ void GMRES::lusol(int* n, double* y, double* x, double* alu, int* jlu, int* ju)
   int i__1, i__2;
 
   /* Local variables */
-  static int i__, k;
+  int i__, k;
 
 /* local variables */
 
@@ -963,6 +1250,79 @@ void GMRES::lusol(int* n, double* y, double* x, double* alu, int* jlu, int* ju)
 }
 
 
+/*=========================================================================*
+ * Solves the system (LU) x = y as lusol, with the LU matrix and (if       *
+ * available) its level scheduling in the workspace: rows in each level of *
+ * L (forward solve) and then of U (backward solve) are solved in parallel *
+ * with the same arithmetic, so the solution is the same as lusol's.       *
+ *=========================================================================*/
+void GMRES::lusol(int* n, double* y, double* x, workspace_t& ws)
+{
+  if (ws.lrow.empty()) {
+    lusol(n, y, x, &ws.alu[0], &ws.jlu[0], &ws.ju[0]);
+    return;
+  }
+
+  /* Parameter adjustments */
+  const double *alu = &ws.alu[0] - 1;
+  const int
+    *jlu  = &ws.jlu[0] - 1,
+    *ju   = &ws.ju[0] - 1,
+    *lrow = &ws.lrow[0] - 1,
+    *urow = &ws.urow[0] - 1,
+    nlevl = static_cast< int >(ws.lptr.size()) - 1,
+    nlevu = static_cast< int >(ws.uptr.size()) - 1;
+  --x;
+  --y;
+
+  #pragma omp parallel
+  {
+    int l, r, i__, k;
+    double t;
+
+    /* forward solve */
+    for (l = 0; l < nlevl; ++l) {
+      #pragma omp for schedule(static)
+      for (r = ws.lptr[l]; r < ws.lptr[l + 1]; ++r) {
+        i__ = lrow[r];
+        t = y[i__];
+        for (k = jlu[i__]; k < ju[i__]; ++k) {
+           t -= alu[k] * x[jlu[k]];
+        }
+        x[i__] = t;
+      }
+    }
+
+    /* backward solve. */
+    for (l = 0; l < nlevu; ++l) {
+      #pragma omp for schedule(static)
+      for (r = ws.uptr[l]; r < ws.uptr[l + 1]; ++r) {
+        i__ = urow[r];
+        t = x[i__];
+        for (k = ju[i__]; k < jlu[i__ + 1]; ++k) {
+           t -= alu[k] * x[jlu[k]];
+        }
+        x[i__] = alu[i__] * t;
+      }
+    }
+  }
+}
+
+
+/*=========================================================================*
+ * Preconditioning operation x = M^-1 y, in place if x and y are the same: *
+ * a multigrid V-cycle if the workspace has a multigrid hierarchy, or      *
+ * the ILU(k) forward and backward solves (lusol) otherwise.               *
+ *=========================================================================*/
+void GMRES::psolve(int* n, double* y, double* x, workspace_t& ws)
+{
+  if (!ws.amg.levels.empty())
+    AMG::vcycle(ws.amg, y, x);
+  else
+    lusol(n, y, x, ws);
+}
+
+
 /*=========================================================================*
  *                                                                         *
  *                 *** ILUT - Preconditioned GMRES ***                     *
@@ -987,6 +1347,11 @@ void GMRES::lusol(int* n, double* y, double* x, double* alu, int* jlu, int* ju)
  * ILU(0) and MILU(0) are also provided for comparison purposes            *
  * USAGE: first call ILUT or ILU0 or MILU0 to set up preconditioner and    *
  * then call pgmres.                                                       *
+ *                                                                         *
+ * Multiple right hand sides are solved together (batched): each one has   *
+ * its own Arnoldi process, with the same arithmetic as if solved alone,   *
+ * but the processes advance in lockstep so that each iteration computes   *
+ * the matrix by vector products of all of them in a single pass over A.   *
  *=========================================================================*
  * Coded by Y. Saad - This version dated May, 7, 1990.                     *
  *=========================================================================*
@@ -996,19 +1361,18 @@ void GMRES::lusol(int* n, double* y, double* x, double* alu, int* jlu, int* ju)
  * ==========                                                              *
  *                                                                         *
  * n     == integer. The dimension of the matrix.                          *
- * im    == size of krylov subspace:  should not exceed 50 in this         *
- *          version (can be reset by changing parameter command for        *
- *          kmax below)                                                    *
- * rhs   == real vector of length n containing the right hand side.        *
+ * nrhs  == integer. The number of right hand sides.                       *
+ * im    == size of krylov subspace (workspace hh, c, s and rs sized to    *
+ *          it, vv to n x (im+1), all per right hand side)                 *
+ * rhs   == real array of size n x nrhs containing the right hand sides.   *
  *          Destroyed on return.                                           *
- * sol   == real vector of length n containing an initial guess to the     *
- *          solution on input. approximate solution on output              *
+ * sol   == real array of size n x nrhs containing an initial guess to the *
+ *          solutions on input. approximate solutions on output            *
  * eps   == tolerance for stopping criterion. process is stopped           *
  *          as soon as ( ||.|| is the euclidean norm):                     *
  *          || current residual||/||initial residual|| <= eps              *
  * maxits== maximum number of iterations allowed                           *
- * iout  == output unit number number for printing intermediate results    *
- *          if (iout .le. 0) nothing is printed out.                       *
+ * iout  == if intermediate results are printed (iout .gt. 0)              *
  *                                                                         *
  * aa, ja,                                                                 *
  * ia    == the input matrix in compressed sparse row format:              *
@@ -1026,235 +1390,257 @@ void GMRES::lusol(int* n, double* y, double* x, double* alu, int* jlu, int* ju)
  *                                                                         *
  * on return:                                                              *
  * ==========                                                              *
- * sol   == contains an approximate solution (upon successful return).     *
+ * sol   == contains approximate solutions (upon successful return).       *
+ * its   == number of iterations performed (maximum of all rhs)            *
+ * res   == residual norm estimate of the last iteration (maximum of all)  *
  * ierr  == integer. Error message with the following meaning.             *
  *          ierr = 0 --> successful return.                                *
  *          ierr = 1 --> convergence not achieved in itmax iterations.     *
  *          ierr =-1 --> the initial guess seems to be the exact           *
  *                       solution (initial residual computed was zero)     *
+ *          (if these differ per rhs, 1 takes precedence over -1)          *
  *                                                                         *
  *=========================================================================*
  *                                                                         *
  * work arrays:                                                            *
  * =============                                                           *
- * vv    == work array of length  n x (im+1) (used to store the Arnoli     *
- *          basis)                                                         *
+ * vv    == work array of length  n x (im+1) x nrhs (used to store the     *
+ *          Arnoldi basis)                                                 *
  *=========================================================================*
  * subroutines called :                                                    *
- * amux   : SPARSKIT routine to do the matrix by vector multiplication     *
- *          delivers y=Ax, given x  -- see SPARSKIT/BLASSM/amux            *
- * lusol : combined forward and backward solves (Preconditioning ope.)     *
+ * amuxm  : matrix by vectors multiplication (one pass over the matrix)    *
+ *          delivers y=Ax, given x for several x and y                     *
+ * psolve : preconditioning operation (ILU(k) solves or multigrid cycle)   *
  * BLAS1  routines.                                                        *
  *=========================================================================*
  *                                                                         *
- * arnoldi size should not exceed kmax=50 in this version..                *
- * to reset modify paramter kmax accordingly.                              *
+ * arnoldi size is only limited by the workspace size (see im above)       *
  *=========================================================================*/
-void GMRES::pgmres(int* n, int* im, double* rhs, double* sol, double* vv, double* eps, int* maxits, int* iout, double* aa, int* ja, int* ia, double* alu, int* jlu, int* ju, int* ierr)
+void GMRES::pgmres(int* n, int* nrhs, int* im, double* rhs, double* sol, double* eps, int* maxits, int* iout, double* aa, int* ja, int* ia, workspace_t& ws, int* itsout, double* res, int* ierr)
 {
-  static double epsmac = 1e-16;
-
-  /* System generated locals */
-  int vv_dim1, vv_offset, i__1, i__2;
-  double d__1, d__2;
-
-  /* Local variables */
-  static double c__[50];
-  static int i__, j, k;
-  static double s[50], t;
-  static int i1, k1;
-  static int n1;
-  static double hh[2550]  /* was [51][50] */;
-  static int ii, jj;
-  static double ro, rs[51], gam;
-  static int its;
-  static double eps1;
+  const double epsmac = 1e-16;
+  int c__1 = 1;
+
+  /* Local variables (1-based indexing on basis vectors, hh, c, s and rs) */
+  const int
+    nv  = *n * (*im + 1),  // per rhs sizes of vv, hh, c/s and rs
+    nh  = (*im + 1) * *im,
+    ldh = *im + 1;
+  int l, i__, j, k, k1, ii, jj, i1, nact;
+  double t, d__1, d__2, gam;
+  double *vv, *hh, *c__, *s, *rs, *z, *x;
+
+  /* per rhs state: current Krylov subspace size, iterations, residual
+     norm, stopping tolerance, status (2 for iterating, otherwise ierr) and
+     if the Arnoldi process is (re)starting */
+  std::vector< int > cur(*nrhs,0), its(*nrhs,0), status(*nrhs,2);
+  std::vector< double > ro(*nrhs,0.), eps1(*nrhs,0.);
+  std::vector< bool > start(*nrhs,true);
+  std::vector< double* > xs, ys;
+
+  /* compute initial residual vectors */
+  for (l = 0; l < *nrhs; ++l) {
+    xs.push_back(sol + l * *n);
+    ys.push_back(&ws.vv[l * nv]);
+  }
+  nact = *nrhs;
+  amuxm(n, &nact, &xs[0], &ys[0], aa, ja, ia);
+  for (l = 0; l < *nrhs; ++l) {
+    vv = &ws.vv[l * nv];
+    z  = rhs + l * *n;
+    for (j = 0; j < *n; ++j) {
+      vv[j] = z[j] - vv[j];
+    }
+  }
 
-  *ierr = 0;
+  while (true) {
 
-  /* Parameter adjustments */
-  --ju;
-  --ia;
-  vv_dim1 = *n;
-  vv_offset = 1 + vv_dim1 * 1;
-  vv -= vv_offset;
-  --sol;
-  --rhs;
-  --aa;
-  --ja;
-  --alu;
-  --jlu;
-
-  /* Function Body */
-  n1 = *n + 1;
-  its = 0;
+    /* outer loop starts here (per rhs).. */
+    for (l = 0; l < *nrhs; ++l) {
+      if (status[l] != 2 || !start[l]) {
+        continue;
+      }
+      vv = &ws.vv[l * nv];
+      rs = &ws.rs[l * ldh] - 1;
+      ro[l] = dnrm2(n, vv, &c__1);
+      if (ro[l] == 0.) {
+        status[l] = -1;
+        continue;
+      }
+      t = 1. / ro[l];
+      for (j = 0; j < *n; ++j) {
+        vv[j] *= t;
+      }
+      if (its[l] == 0) {
+        eps1[l] = *eps * ro[l];
+      }
 
-  /* compute initial residual vector */
-  amux(n, &sol[1], &vv[vv_offset], &aa[1], &ja[1], &ia[1]);
-  i__1 = *n;
-  for (j = 1; j <= i__1; ++j) {
-     vv[j + vv_dim1] = rhs[j] - vv[j + vv_dim1];
-  }
+      /* initialize 1-st term  of rhs of hessenberg system.. */
+      rs[1] = ro[l];
+      cur[l] = 0;
+      start[l] = false;
+    }
 
-  /* outer loop starts here.. */
-L20:
-  ro = dnrm2(n, &vv[vv_offset], &c__1);
-  if (ro == 0.) {
-    *ierr = -1;
-    return;
-  }
-  t = 1. / ro;
-  i__1 = *n;
-  for (j = 1; j <= i__1; ++j) {
-     vv[j + vv_dim1] *= t;
-  }
-  if (its == 0) {
-     eps1 = *eps * ro;
-  }
+    /* precondition and multiply (single pass over A) */
+    xs.clear();
+    ys.clear();
+    for (l = 0; l < *nrhs; ++l) {
+      if (status[l] != 2) {
+        continue;
+      }
+      i__ = ++cur[l];
+      ++its[l];
+      vv = &ws.vv[l * nv] - *n;
+      z  = rhs + l * *n;
+      psolve(n, &vv[i__ * *n], z, ws);
+      xs.push_back(z);
+      ys.push_back(&vv[(i__ + 1) * *n]);
+    }
+    if (xs.empty()) {
+      break;
+    }
+    nact = static_cast< int >(xs.size());
+    amuxm(n, &nact, &xs[0], &ys[0], aa, ja, ia);
 
-  /* initialize 1-st term  of rhs of hessenberg system.. */
-  rs[0] = ro;
-  i__ = 0;
+    for (l = 0; l < *nrhs; ++l) {
+      if (status[l] != 2) {
+        continue;
+      }
+      i__ = cur[l];
+      i1  = i__ + 1;
+      vv  = &ws.vv[l * nv] - *n;     // vv[j * n] is basis vector j
+      hh  = &ws.hh[l * nh] - ldh - 1;  // hh[r + c * ldh] is entry (r,c)
+      c__ = &ws.c[l * *im] - 1;
+      s   = &ws.s[l * *im] - 1;
+      rs  = &ws.rs[l * ldh] - 1;
+      z   = rhs + l * *n;
+      x   = sol + l * *n;
+
+      /* modified gram - schmidt... */
+      for (j = 1; j <= i__; ++j) {
+        t = ddot(n, &vv[j * *n], &c__1, &vv[i1 * *n], &c__1);
+        hh[j + i__ * ldh] = t;
+        d__1 = -t;
+        daxpy(n, &d__1, &vv[j * *n], &c__1, &vv[i1 * *n], &c__1);
+      }
+      t = dnrm2(n, &vv[i1 * *n], &c__1);
+      hh[i1 + i__ * ldh] = t;
+      if (t != 0.) {
+        t = 1. / t;
+        for (k = 0; k < *n; ++k) {
+          vv[i1 * *n + k] *= t;
+        }
+      }
 
-L4:
-  ++i__;
-  ++its;
-  i1 = i__ + 1;
-  lusol(n, &vv[i__ * vv_dim1 + 1], &rhs[1], &alu[1], &jlu[1], &ju[1]);
-  amux(n, &rhs[1], &vv[i1 * vv_dim1 + 1], &aa[1], &ja[1], &ia[1]);
+      /* done with modified gram schimd and arnoldi step.. */
+      /* now  update factorization of hh */
+      /* perfrom previous transformations on i-th column of h */
+      for (k = 2; k <= i__; ++k) {
+        k1 = k - 1;
+        t = hh[k1 + i__ * ldh];
+        hh[k1 + i__ * ldh] = c__[k1] * t + s[k1] * hh[k + i__ * ldh];
+        hh[k + i__ * ldh] = -s[k1] * t + c__[k1] * hh[k + i__ * ldh];
+      }
 
-  /* modified gram - schmidt... */
-  i__1 = i__;
-  for (j = 1; j <= i__1; ++j) {
-     t = ddot(n, &vv[j * vv_dim1 + 1], &c__1, &vv[i1 * vv_dim1 + 1], &c__1);
-     hh[j + i__ * 51 - 52] = t;
-     d__1 = -t;
-     daxpy(n, &d__1, &vv[j * vv_dim1 + 1], &c__1, &vv[i1 * vv_dim1 + 1], &c__1);
-  }
-  t = dnrm2(n, &vv[i1 * vv_dim1 + 1], &c__1);
-  hh[i1 + i__ * 51 - 52] = t;
-  if (t == 0.) {
-     goto L58;
-  }
-  t = 1. / t;
-  i__1 = *n;
-  for (k = 1; k <= i__1; ++k) {
-     vv[k + i1 * vv_dim1] *= t;
-  }
+      /* Computing 2nd power */
+      d__1 = hh[i__ + i__ * ldh];
+      d__2 = hh[i1 + i__ * ldh];
+      gam = sqrt(d__1 * d__1 + d__2 * d__2);
 
-  /* done with modified gram schimd and arnoldi step.. */
-  /* now  update factorization of hh */
-L58:
-  if (i__ == 1) {
-     goto L121;
-  }
+      /* if gamma is zero then any small value will do... */
+      /* will affect only residual estimate */
+      if (gam == 0.) {
+        gam = epsmac;
+      }
 
-  /* perfrom previous transformations on i-th column of h */
-  i__1 = i__;
-  for (k = 2; k <= i__1; ++k) {
-     k1 = k - 1;
-     t = hh[k1 + i__ * 51 - 52];
-     hh[k1 + i__ * 51 - 52] = c__[k1 - 1] * t + s[k1 - 1] * hh[k + i__ *51 - 52];
-     hh[k + i__ * 51 - 52] = -s[k1 - 1] * t + c__[k1 - 1] * hh[k + i__ *51 - 52];
-  }
+      /* get next plane rotation */
+      c__[i__] = hh[i__ + i__ * ldh] / gam;
+      s[i__] = hh[i1 + i__ * ldh] / gam;
+      rs[i1] = -s[i__] * rs[i__];
+      rs[i__] = c__[i__] * rs[i__];
+
+      /* determine residual norm and test for convergence- */
+      hh[i__ + i__ * ldh] = c__[i__] * hh[i__ + i__ * ldh] + s[i__] * hh[i1 + i__ * ldh];
+      ro[l] = std::abs(rs[i1]);
+
+      if (*iout > 0) {
+        CFinfo << "GMRES: iteration/residual: " << its[l] << '/' << ro[l];
+        if (*nrhs > 1)
+          CFinfo << " (rhs " << l << ')';
+        CFinfo << CFendl;
+      }
 
-L121:
-  /* Computing 2nd power */
-  d__1 = hh[i__ + i__ * 51 - 52];
+      if (its[l] < *maxits && (its[l] <= 1 || (i__ < *im && ro[l] > eps1[l]))) {
+        continue;
+      }
 
-  /* Computing 2nd power */
-  d__2 = hh[i1 + i__ * 51 - 52];
-  gam = sqrt(d__1 * d__1 + d__2 * d__2);
+      /* now compute solution. first solve upper triangular system. */
+      rs[i__] /= hh[i__ + i__ * ldh];
+      for (ii = 2; ii <= i__; ++ii) {
+        k = i__ - ii + 1;
+        k1 = k + 1;
+        t = rs[k];
+        for (j = k1; j <= i__; ++j) {
+          t -= hh[k + j * ldh] * rs[j];
+        }
+        rs[k] = t / hh[k + k * ldh];
+      }
 
-  /* if gamma is zero then any small value will do... */
-  /* will affect only residual estimate */
-  if (gam == 0.) {
-     gam = epsmac;
-  }
+      /* form linear combination of v(*,i)'s to get solution */
+      t = rs[1];
+      for (k = 0; k < *n; ++k) {
+        z[k] = vv[*n + k] * t;
+      }
+      for (j = 2; j <= i__; ++j) {
+        t = rs[j];
+        for (k = 0; k < *n; ++k) {
+          z[k] += t * vv[j * *n + k];
+        }
+      }
 
-  /* get next plane rotation */
-  c__[i__ - 1] = hh[i__ + i__ * 51 - 52] / gam;
-  s[i__ - 1] = hh[i1 + i__ * 51 - 52] / gam;
-  rs[i1 - 1] = -s[i__ - 1] * rs[i__ - 1];
-  rs[i__ - 1] = c__[i__ - 1] * rs[i__ - 1];
-
-  /* determine residual norm and test for convergence- */
-  hh[i__ + i__ * 51 - 52] = c__[i__ - 1] * hh[i__ + i__ * 51 - 52]
-                            + s[i__ - 1] * hh[i1 + i__ * 51 - 52];
-  ro = (d__1 = rs[i1 - 1], std::abs(d__1));
-
-  //if (*iout>0)
-  //  std::cout << "GMRES: iteration/residual: " << its << '/' << ro << std::endl;
-
-  if (its<=1)
-    goto L4;
-  if (i__<*im && ro>eps1)
-    goto L4;
-
-  /* now compute solution. first solve upper triangular system. */
-  rs[i__ - 1] /= hh[i__ + i__ * 51 - 52];
-  i__1 = i__;
-  for (ii = 2; ii <= i__1; ++ii) {
-     k = i__ - ii + 1;
-     k1 = k + 1;
-     t = rs[k - 1];
-     i__2 = i__;
-     for (j = k1; j <= i__2; ++j) {
-  t -= hh[k + j * 51 - 52] * rs[j - 1];
-     }
-     rs[k - 1] = t / hh[k + k * 51 - 52];
-  }
+      /* call preconditioner. */
+      psolve(n, z, z, ws);
+      for (k = 0; k < *n; ++k) {
+        x[k] += z[k];
+      }
 
-  /* form linear combination of v(*,i)'s to get solution */
-  t = rs[0];
-  i__1 = *n;
-  for (k = 1; k <= i__1; ++k) {
-     rhs[k] = vv[k + vv_dim1] * t;
-  }
-  i__1 = i__;
-  for (j = 2; j <= i__1; ++j) {
-     t = rs[j - 1];
-     i__2 = *n;
-     for (k = 1; k <= i__2; ++k) {
-  rhs[k] += t * vv[k + j * vv_dim1];
-     }
-  }
+      /* restart outer loop  when necessary */
+      if (ro[l] <= eps1[l]) {
+        status[l] = 0;
+        continue;
+      }
+      if (its[l] >= *maxits) {
+        status[l] = 1;
+        continue;
+      }
 
-  /* call preconditioner. */
-  lusol(n, &rhs[1], &rhs[1], &alu[1], &jlu[1], &ju[1]);
-  i__1 = *n;
-  for (k = 1; k <= i__1; ++k) {
-     sol[k] += rhs[k];
-  }
+      /* else compute residual vector and continue.. */
+      for (j = 1; j <= i__; ++j) {
+        jj = i1 - j + 1;
+        rs[jj - 1] = -s[jj - 1] * rs[jj];
+        rs[jj] = c__[jj - 1] * rs[jj];
+      }
+      for (j = 1; j <= i1; ++j) {
+        t = rs[j];
+        if (j == 1) {
+          t += -1.;
+        }
+        daxpy(n, &t, &vv[j * *n], &c__1, &vv[*n], &c__1);
+      }
 
-  /* restart outer loop  when necessary */
-  if (ro <= eps1) {
-    *ierr = 0;
-    return;
-  }
-  if (its >= *maxits) {
-    *ierr = 1;
-    return;
+      /* restart outer loop. */
+      start[l] = true;
+    }
   }
 
-  /* else compute residual vector and continue.. */
-  i__1 = i__;
-  for (j = 1; j <= i__1; ++j) {
-     jj = i1 - j + 1;
-     rs[jj - 2] = -s[jj - 2] * rs[jj - 1];
-     rs[jj - 1] = c__[jj - 2] * rs[jj - 1];
-  }
-  i__1 = i1;
-  for (j = 1; j <= i__1; ++j) {
-     t = rs[j - 1];
-     if (j == 1) {
-  t += -1.;
-     }
-     daxpy(n, &t, &vv[j * vv_dim1 + 1], &c__1, &vv[vv_offset], &c__1);
+  *itsout = 0;
+  *res = 0.;
+  *ierr = 0;
+  for (l = 0; l < *nrhs; ++l) {
+    *itsout = std::max(*itsout, its[l]);
+    *res = std::max(*res, ro[l]);
+    *ierr = (*ierr == 1 ? 1 : (status[l] ? status[l] : *ierr));
   }
-
-  /* restart outer loop. */
-   goto L20;
 }
 
 
@@ -11,6 +11,7 @@
 
 #include "LibLSS.hpp"
 #include "linearsystem.hpp"
+#include "AMG.hpp"
 
 
 namespace cf3 {
@@ -18,7 +19,10 @@ namespace lss {
 
 
 /**
- * implementation of a serial GMRES linear system solver (double p.)
+ * implementation of a restarted, ILU(k) (or AMG) preconditioned GMRES linear
+ * system solver; with OpenMP, matrix-vector products run in parallel, and the
+ * ILU(k) factorization and triangular solves too if level scheduled (option
+ * LevelScheduling) (double p.)
  */
 class lss_API GMRES : public linearsystem< double >
 {
@@ -33,9 +37,7 @@ class lss_API GMRES : public linearsystem< double >
   GMRES(const std::string& name,
         const size_t& _size_i=size_t(),
         const size_t& _size_j=size_t(),
-        const size_t& _size_k=1 ) : linearsystem< double >(name), c__1(1) {
-    linearsystem< double >::initialize(_size_i,_size_j,_size_k);
-  }
+        const size_t& _size_k=1 );
 
   /// Linear system solving: x = A^-1 b
   GMRES& solve();
@@ -50,15 +52,53 @@ class lss_API GMRES : public linearsystem< double >
   GMRES& swap(GMRES& _other);
 
 
+ public:
+  // preconditioner functions (reentrant, any state is kept in the workspace),
+  // also used by other Krylov solvers
+
+  /// Solver workspace: preconditioner (alu, jlu, ju), preconditioner work
+  /// arrays (w, jw), Arnoldi basis (vv), Hessenberg matrix (hh), Givens
+  /// rotations (c, s), Hessenberg system right-hand side (rs) and, if level
+  /// scheduled, the preconditioner rows per level of L (lptr, lrow) and U
+  /// (uptr, urow); or, instead of ILU(k), a multigrid hierarchy (amg)
+  struct workspace_t {
+    workspace_t() : pattern(0), lfil(-1), age(0) {}
+    std::vector< double > alu, w, vv, hh, c, s, rs;
+    std::vector< int > jlu, ju, jw, lptr, lrow, uptr, urow;
+    AMG::hierarchy_t amg;
+    size_t pattern;  // matrix structure version of preconditioner
+    int    lfil;     // ... level of fill
+    int    age;      // ... and number of solves since calculated
+  };
+
+  /// ILU(k) preconditioner (re)calculation in the workspace: structure is
+  /// kept while the matrix structure version and level of fill are unchanged,
+  /// values are recalculated every given number of solves (0 for only with
+  /// the structure), optionally level scheduled; returns 0 or iluk error code
+  static int ilu(matrix_t::matrix_compressed_t& A, const size_t& pattern, const int& lfil, const int& refresh, const bool& level_scheduling, workspace_t& ws);
+
+  /// ILU(k) preconditioner error description
+  static std::string ilu_message(const int& err);
+
+  static int iluk(int *n, double *a, int *ja, int *ia, int *lfil, std::vector< double >& alu, std::vector< int >& jlu, int *ju, int *iwk, double *w, int *jw, int *ierr);
+  static void ilunum(int *n, double *a, int *ja, int *ia, double *alu, int *jlu, int *ju, int *iw, int *ierr);
+  static void ilunum(int *n, double *a, int *ja, int *ia, double *alu, int *jlu, int *ju, int *nlev, int *lptr, int *lrow, int *ierr);
+  static int ilurow(int i, double *a, int *ja, int *ia, double *alu, int *jlu, int *ju, int *iw);
+  static void levels(int *n, int *jlu, int *ju, std::vector< int >& lptr, std::vector< int >& lrow, std::vector< int >& uptr, std::vector< int >& urow);
+  static void lusol(int *n, double *y, double *x, double *alu, int *jlu, int *ju);
+  static void lusol(int *n, double *y, double *x, workspace_t& ws);
+  static void psolve(int *n, double *y, double *x, workspace_t& ws);
+
+
  private:
-  // internal functions
-  int iluk(int *n, double *a, int *ja, int *ia, int *lfil, double*& aluold, int*& jluold, int *ju, int*& levsold, int *iwk, double *w, int *jw, int *ierr);
-  int daxpy(int *n, double *da, double *dx, int *incx, double *dy, int *incy);
-  double ddot(int *n, double *dx, int *incx, double *dy, int *incy);
-  double dnrm2(int *n, double *dx, int *incx);
-  void amux(int *n, double *x, double *y, double *a, int *ja, int *ia);
-  void lusol(int *n, double *y, double *x, double *alu, int *jlu, int *ju);
-  void pgmres(int *n, int *im, double *rhs, double *sol, double *vv, double *eps, int *maxits, int*iout, double *aa, int *ja, int *ia, double *alu, int *jlu, int *ju, int *ierr);
+  // internal functions (reentrant, any state is kept in the workspace)
+
+  static int daxpy(int *n, double *da, double *dx, int *incx, double *dy, int *incy);
+  static double ddot(int *n, double *dx, int *incx, double *dy, int *incy);
+  static double dnrm2(int *n, double *dx, int *incx);
+  static void amux(int *n, double *x, double *y, double *a, int *ja, int *ia);
+  static void amuxm(int *n, int *m, double **x, double **y, double *a, int *ja, int *ia);
+  static void pgmres(int *n, int *nrhs, int *im, double *rhs, double *sol, double *eps, int *maxits, int*iout, double *aa, int *ja, int *ia, workspace_t& ws, int *its, double *res, int *ierr);
 
 
  protected:
@@ -76,6 +116,8 @@ class lss_API GMRES : public linearsystem< double >
   void A___clear()                                      { m_A.clear();    }
   void A___zerorow(const size_t& i)                     { m_A.zerorow(i); }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
+  void A___add_block(const std::vector< size_t >& _rows, const std::vector< size_t >& _cols, const std::vector< double >& _values) { m_A.add_block(_rows,_cols,_values); }
+  bool A___lock(const bool& _lock) { m_A.lock(_lock); return true; }
 
   /// matrix inspecting
   void   A___print(std::ostream& o, const print_t& l=print_auto) const { m_A.print(o,l); }
@@ -85,7 +127,19 @@ class lss_API GMRES : public linearsystem< double >
  protected:
   // storage
   matrix_t m_A;
-  int c__1;
+
+  // options
+  double m_rtol;     // relative residual reduction tolerance
+  int    m_restart;  // Krylov subspace size (restart)
+  int    m_maxits;   // maximum number of iterations
+  int    m_lfil;     // ILU(k) preconditioner level of fill
+  bool   m_monitor;  // if each iteration should be printed
+  std::string m_pc_type;  // preconditioner type
+  int    m_pc_refresh;  // preconditioner recalculation period (solves)
+  bool   m_level_scheduling;  // if preconditioner is level scheduled (parallel)
+
+  // storage (kept between solves)
+  workspace_t m_ws;
 
 };
 
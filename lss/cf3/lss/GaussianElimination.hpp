@@ -10,7 +10,6 @@
 
 
 #include <cmath>
-#include "boost/progress.hpp"
 
 #include "LibLSS.hpp"
 #include "linearsystem.hpp"
@@ -44,63 +43,99 @@ class lss_API GaussianElimination : public linearsystem< T >
 
   /// Linear system solving: x = A^-1 b
   GaussianElimination& solve() {
-    const size_t
-      N(linearsystem< T >::size(0)),
-      K(linearsystem< T >::size(2));
-
-    this->m_x = this->m_b;
+    return factorize().solve_only();
+  }
 
-    boost::progress_display pbar(N-1);
-    for (size_t m=0; m<N-1; ++m, ++pbar) {
-
-      // put row with highest diagonal element on top
-      T C = m_A(m,m);
-      for (size_t n=m+1; n<N; ++n) {
-        if (std::abs(m_A(n,m)) > std::abs(C)) {
-          for (size_t p=m; p<N; ++p) {
-            C = m_A(m,p);
-            m_A(m,p) = m_A(n,p);
-            m_A(n,p) = C;
-          }
-          for (size_t k=0; k<K; ++k)
-            std::swap( this->x(m,k), this->x(n,k) );
-          C = m_A(m,m);
+  /// Linear system matrix factorization (LU, kept apart so A is preserved):
+  /// blocked right-looking LU with partial pivoting, where each panel of
+  /// columns is factorized by rows elimination, then the trailing matrix is
+  /// updated by the panel at once (rows in parallel, a cache-sized block of
+  /// columns at a time)
+  GaussianElimination& factorize() {
+    const size_t N(this->size(0));
+    if (!m_A.m_size.is_square_size())
+      throw std::runtime_error("GaussianElimination: system matrix must be square.");
+    m_LU = m_A;
+    m_ipiv.assign(N,0);
+    T* a = N? &m_LU.a[0] : NULL;
+
+    const size_t NB = 64;  // panel size (and trailing matrix columns block size /4)
+    for (size_t k0=0; k0<N; k0+=NB) {
+      const size_t k1 = std::min(k0+NB,N);
+
+      // panel factorization (columns k0 to k1), pivoting on the largest
+      // entry of each column with a single (contiguous) rows swap
+      for (size_t m=k0; m<k1; ++m) {
+        size_t p = m;
+        for (size_t n=m+1; n<N; ++n)
+          if (std::abs(a[n*N+m])>std::abs(a[p*N+m]))
+            p = n;
+        m_ipiv[m] = p;
+        if (p!=m)
+          std::swap_ranges(a+m*N,a+(m+1)*N,a+p*N);
+
+        const T C = a[m*N+m];
+        if (std::abs(C)<1.e-32) {
+          m_LU.clear();
+          m_ipiv.clear();
+          std::ostringstream msg;
+          msg << "GaussianElimination: matrix is singular (line:" << m << ",C:" << std::abs(C) << ").";
+          throw std::runtime_error(msg.str());
+        }
+        for (size_t n=m+1; n<N; ++n) {
+          const T L = (a[n*N+m] /= C);
+          axpy(-L,a+m*N+m+1,a+n*N+m+1,k1-m-1);
         }
       }
 
-      // check if diagonal element is (close to) zero
-      if (std::abs(C)<1.e-32) {
-        std::ostringstream msg;
-        msg << "error: matrix is singular (line:" << m << ",C:" << std::abs(C) << ").";
-        throw std::runtime_error(msg.str());
-      }
-
-      // normalize row m
-      for (size_t n=m+1; n<N; ++n)
-        m_A(m,n) /= C;
-      for (size_t k=0; k<K; ++k)
-        this->x(m,k) /= C;
-
-      // subtract row m from subsequent rows
-      for (size_t n=m+1; n<N; ++n) {
-        C = m_A(n,m);
-        for (size_t p=m+1; p<N; ++p)
-          m_A(n,p) -= C*m_A(m,p);
-        for (size_t k=0; k<K; ++k)
-          this->x(n,k) -= C * this->x(m,k);
+      // U12 block, by the panel's unit lower triangular part
+      for (size_t m=k0; m<k1; ++m)
+        for (size_t n=m+1; n<k1; ++n)
+          axpy(-a[n*N+m],a+m*N+k1,a+n*N+k1,N-k1);
+
+      // trailing matrix update A22 -= L21 U12, a block of columns at a time
+      // so that the U12 block stays in cache
+      const int n0 = static_cast< int >(k1), n1 = static_cast< int >(N);
+      for (size_t c0=k1; c0<N; c0+=4*NB) {
+        const size_t nc = std::min(4*NB,N-c0);
+        #pragma omp parallel for schedule(static) if(n1-n0>static_cast< int >(NB))
+        for (int n=n0; n<n1; ++n) {
+          size_t m = k0;
+          for (; m+8<=k1; m+=8)
+            axpy8(a+n*N+m,a+m*N+c0,N,a+n*N+c0,nc);
+          for (; m<k1; ++m)
+            axpy(-a[n*N+m],a+m*N+c0,a+n*N+c0,nc);
+        }
       }
     }
+    return *this;
+  }
 
-    // solve by back substitution
-    for (size_t k=0; k<K; ++k)
-      this->x(N-1,k) /= m_A(N-1,N-1);
-    for (size_t p=0; p<N-1; ++p) {
-      size_t m = N-p-2;
-      for (size_t n=m+1; n<N; ++n)
-        for (size_t k=0; k<K; ++k)
-          this->x(m,k) -= m_A(m,n) * this->x(n,k);
-    }
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  /// (each right-hand side in parallel)
+  GaussianElimination& solve_only() {
+    const size_t
+      N(this->size(0)),
+      K(this->size(2));
+    if (m_ipiv.size()!=N || m_LU.a.size()!=N*N)
+      factorize();
 
+    this->m_x = this->m_b;
+    const T* a = N? &m_LU.a[0] : NULL;
+    #pragma omp parallel for schedule(static)
+    for (int k=0; k<static_cast< int >(K); ++k) {
+      T* x = &this->m_x.a[k*N];
+
+      // row interchanges, then forward (unit L) and back (U) substitutions
+      for (size_t m=0; m<N; ++m)
+        std::swap(x[m],x[m_ipiv[m]]);
+      for (size_t m=1; m<N; ++m)
+        x[m] -= dot(a+m*N,x,m);
+      for (size_t p=0; p<N; ++p) {
+        const size_t m = N-p-1;
+        x[m] = (x[m] - dot(a+m*N+m+1,x+m+1,N-m-1))/a[m*N+m];
+      }
+    }
     return *this;
   }
 
@@ -122,7 +157,9 @@ class lss_API GaussianElimination : public linearsystem< T >
   /// Linear system copy
   GaussianElimination& copy(const GaussianElimination& _other) {
     linearsystem< T >::copy(_other);
-    m_A = _other.m_A;
+    m_A    = _other.m_A;
+    m_LU   = _other.m_LU;
+    m_ipiv = _other.m_ipiv;
     return *this;
   }
 
@@ -131,10 +168,48 @@ class lss_API GaussianElimination : public linearsystem< T >
   {
     linearsystem< T >::swap(_other);
     m_A.swap(_other.m_A);
+    m_LU.swap(_other.m_LU);
+    m_ipiv.swap(_other.m_ipiv);
     return *this;
   }
 
 
+ private:
+  // internal functions
+
+  /// Vector update y += alpha x (contiguous, vectorizable)
+  static void axpy(const T& alpha, const T* x, T* y, const size_t& n) {
+    for (size_t i=0; i<n; ++i)
+      y[i] += alpha*x[i];
+  }
+
+  /// Vector update by eight vectors at once y -= l0 x0 + ... + l7 x7, the x
+  /// vectors a given stride apart (so y is loaded/stored once for eight)
+  static void axpy8(const T* l, const T* x, const size_t& stride, T* y, const size_t& n) {
+    const T l0(l[0]), l1(l[1]), l2(l[2]), l3(l[3]), l4(l[4]), l5(l[5]), l6(l[6]), l7(l[7]);
+    const T
+      *x0 = x,          *x1 = x0+stride, *x2 = x1+stride, *x3 = x2+stride,
+      *x4 = x3+stride,  *x5 = x4+stride, *x6 = x5+stride, *x7 = x6+stride;
+    for (size_t i=0; i<n; ++i)
+      y[i] -= (l0*x0[i] + l1*x1[i] + l2*x2[i] + l3*x3[i])
+            + (l4*x4[i] + l5*x5[i] + l6*x6[i] + l7*x7[i]);
+  }
+
+  /// Dot product x'y (contiguous, vectorizable)
+  static T dot(const T* x, const T* y, const size_t& n) {
+    T s = T();
+    for (size_t i=0; i<n; ++i)
+      s += x[i]*y[i];
+    return s;
+  }
+
+  /// Release LU factorization
+  void release() {
+    m_LU.clear();
+    m_ipiv.clear();
+  }
+
+
  protected:
   // linear system matrix interfacing
 
@@ -143,11 +218,11 @@ class lss_API GaussianElimination : public linearsystem< T >
         T& A(const size_t& i, const size_t& j)       { return m_A(i,j); }
 
   /// matrix modifiers
-  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j); }
-  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); }
-  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  }
+  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j); release(); }
+  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); release(); }
+  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  release(); }
   void A___assign(const double& _value)                 { m_A = _value;   }
-  void A___clear()                                      { m_A.clear();    }
+  void A___clear()                                      { m_A.clear();    release(); }
   void A___zerorow(const size_t& i)                     { m_A.zerorow(i); }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
 
@@ -159,6 +234,8 @@ class lss_API GaussianElimination : public linearsystem< T >
  protected:
   // storage
   matrix_t m_A;
+  matrix_t m_LU;                 // LU factorization (A is left intact)
+  std::vector< size_t > m_ipiv;  // ... and pivot rows
 
 };
 
@@ -9,6 +9,9 @@
 #define cf3_lss_LAPACK_hpp
 
 
+#include <limits>
+
+#include "common/Log.hpp"
 #include "LibLSS.hpp"
 #include "linearsystem.hpp"
 
@@ -25,6 +28,14 @@ extern "C"
   void zgesv_(int* n, int* nrhs, zdouble* a, int* lda, int* ipiv, zdouble* b, int* ldb, int* info);
   void sgesv_(int* n, int* nrhs, float*   a, int* lda, int* ipiv, float*   b, int* ldb, int* info);
   void cgesv_(int* n, int* nrhs, zfloat*  a, int* lda, int* ipiv, zfloat*  b, int* ldb, int* info);
+  void dgetrf_(int* m, int* n, double*  a, int* lda, int* ipiv, int* info);
+  void zgetrf_(int* m, int* n, zdouble* a, int* lda, int* ipiv, int* info);
+  void sgetrf_(int* m, int* n, float*   a, int* lda, int* ipiv, int* info);
+  void cgetrf_(int* m, int* n, zfloat*  a, int* lda, int* ipiv, int* info);
+  void dgetrs_(const char* trans, int* n, int* nrhs, const double*  a, int* lda, const int* ipiv, double*  b, int* ldb, int* info);
+  void zgetrs_(const char* trans, int* n, int* nrhs, const zdouble* a, int* lda, const int* ipiv, zdouble* b, int* ldb, int* info);
+  void sgetrs_(const char* trans, int* n, int* nrhs, const float*   a, int* lda, const int* ipiv, float*   b, int* ldb, int* info);
+  void cgetrs_(const char* trans, int* n, int* nrhs, const zfloat*  a, int* lda, const int* ipiv, zfloat*  b, int* ldb, int* info);
   void dgemm_(const char *transa, const char *transb, const int *m, const int *n, const int *k, const double  *alpha, const double  *a, const int *lda, const double  *b, const int *ldb, const double  *beta, double  *c, const int *ldc);
   void zgemm_(const char *transa, const char *transb, const int *m, const int *n, const int *k, const zdouble *alpha, const zdouble *a, const int *lda, const zdouble *b, const int *ldb, const zdouble *beta, zdouble *c, const int *ldc);
   void sgemm_(const char *transa, const char *transb, const int *m, const int *n, const int *k, const float   *alpha, const float   *a, const int *lda, const float   *b, const int *ldb, const float   *beta, float   *c, const int *ldc);
@@ -50,31 +61,48 @@ class lss_API LAPACK : public linearsystem< T >
          const size_t& _size_i=size_t(),
          const size_t& _size_j=size_t(),
          const size_t& _size_k=1 ) : linearsystem< T >(name) {
+    m_anorm = 0.;
+    m_mixed_precision = false;
+    m_mixed_maxits    = 30;
+    if (type_is_equal< T, double >() || type_is_equal< T, zdouble >()) {
+      this->options().add("MixedPrecision", m_mixed_precision).link_to(&m_mixed_precision).mark_basic().description("if the matrix is factorized in single precision, recovering double precision accuracy by iterative refinement (half the factor memory, falls back to double precision if refinement doesn't converge, default false)");
+      this->options().add("maxits", m_mixed_maxits).link_to(&m_mixed_maxits).mark_basic().description("mixed precision only: maximum number of iterative refinement steps (default 30)");
+      this->properties().add("iterations",int(0));
+    }
     linearsystem< T >::initialize(_size_i,_size_j,_size_k);
   }
 
   /// Linear system solving: x = A^-1 b
   LAPACK& solve() {
+    return factorize().solve_only();
+  }
+
+  /// Linear system matrix factorization (LU, kept apart so A is preserved)
+  LAPACK& factorize() {
+    factorization(m_mixed_precision);
+    return *this;
+  }
+
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  LAPACK& solve_only() {
+    const char trans = 'N';
     int n    = static_cast< int >(this->size(0));
     int nrhs = static_cast< int >(this->size(2));
     int err  = 0;
-    std::vector< int > ipiv(n);
+    if (m_ipiv.size()!=this->size(0))
+      factorize();
+    if (!m_LUs.empty() && solve_refine())
+      return *this;
 
-    if (!m_A.m_size.is_square_size()) { err = -17; }
-    else if (type_is_equal< T, double  >()) { this->m_x=this->m_b; dgesv_( &n, &nrhs, (double*)  &m_A.a[0], &n, &ipiv[0], (double*)  &this->m_x.a[0], &n, &err ); }
-    else if (type_is_equal< T, zdouble >()) { this->m_x=this->m_b; zgesv_( &n, &nrhs, (zdouble*) &m_A.a[0], &n, &ipiv[0], (zdouble*) &this->m_x.a[0], &n, &err ); }
-    else if (type_is_equal< T, float   >()) { this->m_x=this->m_b; sgesv_( &n, &nrhs, (float*)   &m_A.a[0], &n, &ipiv[0], (float*)   &this->m_x.a[0], &n, &err ); }
-    else if (type_is_equal< T, zfloat  >()) { this->m_x=this->m_b; cgesv_( &n, &nrhs, (zfloat*)  &m_A.a[0], &n, &ipiv[0], (zfloat*)  &this->m_x.a[0], &n, &err ); }
+    this->m_x = this->m_b;
+    if      (type_is_equal< T, double  >()) { dgetrs_( &trans, &n, &nrhs, (double*)  &m_LU.a[0], &n, &m_ipiv[0], (double*)  &this->m_x.a[0], &n, &err ); }
+    else if (type_is_equal< T, zdouble >()) { zgetrs_( &trans, &n, &nrhs, (zdouble*) &m_LU.a[0], &n, &m_ipiv[0], (zdouble*) &this->m_x.a[0], &n, &err ); }
+    else if (type_is_equal< T, float   >()) { sgetrs_( &trans, &n, &nrhs, (float*)   &m_LU.a[0], &n, &m_ipiv[0], (float*)   &this->m_x.a[0], &n, &err ); }
+    else if (type_is_equal< T, zfloat  >()) { cgetrs_( &trans, &n, &nrhs, (zfloat*)  &m_LU.a[0], &n, &m_ipiv[0], (zfloat*)  &this->m_x.a[0], &n, &err ); }
     else { err = -42; }
 
-    std::ostringstream msg;
-    err==-17? msg << "LAPACK: system matrix must be square." :
-    err==-42? msg << "LAPACK: precision not implemented." :
-    err<0?    msg << "LAPACK: invalid " << err << "'th argument to dgesv_()/sgesv_()." :
-    err>0?    msg << "LAPACK: triangular factor matrix U(" << (err-1) << ',' << (err-1) << ") is zero, so A is singular (not invertible)." :
-              msg;
     if (err)
-      throw std::runtime_error(msg.str());
+      throw std::runtime_error(err_message(err));
     return *this;
   }
 
@@ -102,7 +130,13 @@ class lss_API LAPACK : public linearsystem< T >
   /// Linear system copy
   LAPACK& copy(const LAPACK& _other) {
     linearsystem< T >::copy(_other);
-    m_A = _other.m_A;
+    m_A    = _other.m_A;
+    m_LU   = _other.m_LU;
+    m_LUs  = _other.m_LUs;
+    m_ipiv = _other.m_ipiv;
+    m_anorm = _other.m_anorm;
+    m_mixed_precision = _other.m_mixed_precision;
+    m_mixed_maxits    = _other.m_mixed_maxits;
     return *this;
   }
 
@@ -111,10 +145,154 @@ class lss_API LAPACK : public linearsystem< T >
   {
     linearsystem< T >::swap(_other);
     m_A.swap(_other.m_A);
+    m_LU.swap(_other.m_LU);
+    m_LUs.swap(_other.m_LUs);
+    m_ipiv.swap(_other.m_ipiv);
+    std::swap(m_anorm,_other.m_anorm);
     return *this;
   }
 
 
+ private:
+  // internal functions
+
+  /// Release LU factorization
+  void release() {
+    m_LU.clear();
+    m_LUs.clear();
+    m_ipiv.clear();
+  }
+
+  /// LU factorization, in single (mixed) or double precision (the precision
+  /// is a parameter, so the option is not changed on fallback)
+  void factorization(const bool& _single) {
+    int n   = static_cast< int >(this->size(0));
+    int err = 0;
+    m_ipiv.assign(n,0);
+    m_LU.clear();
+    m_LUs.clear();
+
+    // mixed precision: factorize a single precision copy, falling back to
+    // double precision if it is singular (or out of range) in single precision
+    if (_single && m_A.m_size.is_square_size() && factorize_single())
+      return;
+
+    m_LU = m_A;
+    if (!m_A.m_size.is_square_size()) { err = -17; }
+    else if (type_is_equal< T, double  >()) { dgetrf_( &n, &n, (double*)  &m_LU.a[0], &n, &m_ipiv[0], &err ); }
+    else if (type_is_equal< T, zdouble >()) { zgetrf_( &n, &n, (zdouble*) &m_LU.a[0], &n, &m_ipiv[0], &err ); }
+    else if (type_is_equal< T, float   >()) { sgetrf_( &n, &n, (float*)   &m_LU.a[0], &n, &m_ipiv[0], &err ); }
+    else if (type_is_equal< T, zfloat  >()) { cgetrf_( &n, &n, (zfloat*)  &m_LU.a[0], &n, &m_ipiv[0], &err ); }
+    else { err = -42; }
+
+    if (err) {
+      m_LU.clear();
+      m_ipiv.clear();
+      throw std::runtime_error(err_message(err));
+    }
+  }
+
+  /// Mixed precision LU factorization in single precision (real or complex
+  /// double precision only, as arrays of doubles rounded to floats), and
+  /// matrix infinity norm; returns if successful
+  bool factorize_single() {
+    if (!type_is_equal< T, double >() && !type_is_equal< T, zdouble >())
+      return false;
+    int n   = static_cast< int >(this->size(0));
+    int err = 0;
+    const size_t ns = m_A.a.size()*(type_is_complex< T >()? 2:1);
+    const double* a = (const double*) &m_A.a[0];
+    for (size_t k=0; k<ns; ++k)
+      if (!(std::abs(a[k])<=static_cast< double >(std::numeric_limits< float >::max())))
+        return false;
+    m_LUs.assign(a,a+ns);
+
+    if      (type_is_equal< T, double  >()) { sgetrf_( &n, &n, (float*)  &m_LUs[0], &n, &m_ipiv[0], &err ); }
+    else if (type_is_equal< T, zdouble >()) { cgetrf_( &n, &n, (zfloat*) &m_LUs[0], &n, &m_ipiv[0], &err ); }
+    if (err) {
+      CFwarn << "LAPACK: single precision factorization failed (" << err_message(err) << "), factorizing in double precision." << CFendl;
+      m_LUs.clear();
+      return false;
+    }
+
+    m_anorm = 0.;
+    for (int i=0; i<n; ++i) {
+      double s = 0.;
+      for (int j=0; j<n; ++j)
+        s += std::abs(m_A(i,j));
+      m_anorm = std::max(m_anorm,s);
+    }
+    return true;
+  }
+
+  /// Mixed precision solving by iterative refinement: x = LUs^-1 b, then
+  /// x += LUs^-1 (b - A x) with the residual in double precision, until
+  /// ||r|| <= ||x|| ||A|| eps sqrt(n) (infinity norms, as LAPACK ?sgesv) for
+  /// all right-hand sides; if not converged, falls back to double precision
+  /// factorization (and returns false)
+  bool solve_refine() {
+    const char trans = 'N';
+    int n    = static_cast< int >(this->size(0));
+    int nrhs = static_cast< int >(this->size(2));
+    int err  = 0;
+    const size_t ns = this->m_b.a.size()*(type_is_complex< T >()? 2:1);
+    const double tol = m_anorm*std::numeric_limits< double >::epsilon()*std::sqrt(static_cast< double >(n));
+
+    std::vector< T > r(this->m_b.a);
+    std::vector< float > rs(ns);
+    int its = 0;
+    for (bool converged=false; !converged; ++its) {
+
+      // single precision correction d = LUs^-1 r, added to x (x = d initially)
+      const double* rd = (const double*) &r[0];
+      for (size_t k=0; k<ns; ++k)
+        rs[k] = static_cast< float >(rd[k]);
+      if      (type_is_equal< T, double  >()) { sgetrs_( &trans, &n, &nrhs, (float*)  &m_LUs[0], &n, &m_ipiv[0], (float*)  &rs[0], &n, &err ); }
+      else if (type_is_equal< T, zdouble >()) { cgetrs_( &trans, &n, &nrhs, (zfloat*) &m_LUs[0], &n, &m_ipiv[0], (zfloat*) &rs[0], &n, &err ); }
+      if (err)
+        throw std::runtime_error(err_message(err));
+      double* x = (double*) &this->m_x.a[0];
+      for (size_t k=0; k<ns; ++k)
+        x[k] = (its? x[k] : 0.) + static_cast< double >(rs[k]);
+
+      // double precision residual r = b - A x, and convergence check
+      r = this->m_b.a;
+      const T alpha(-1.), beta(1.);
+      if      (type_is_equal< T, double  >()) { dgemm_(&trans, &trans, &n, &nrhs, &n, (double*)  &alpha, (double*)  &m_A.a[0], &n, (double*)  &this->m_x.a[0], &n, (double*)  &beta, (double*)  &r[0], &n); }
+      else if (type_is_equal< T, zdouble >()) { zgemm_(&trans, &trans, &n, &nrhs, &n, (zdouble*) &alpha, (zdouble*) &m_A.a[0], &n, (zdouble*) &this->m_x.a[0], &n, (zdouble*) &beta, (zdouble*) &r[0], &n); }
+      converged = true;
+      for (int k=0; k<nrhs && converged; ++k) {
+        double rnorm = 0., xnorm = 0.;
+        for (int i=0; i<n; ++i) {
+          rnorm = std::max(rnorm,static_cast< double >(std::abs(r[k*n+i])));
+          xnorm = std::max(xnorm,static_cast< double >(std::abs(this->m_x.a[k*n+i])));
+        }
+        converged = (rnorm<=xnorm*tol);
+      }
+
+      if (!converged && its>=m_mixed_maxits) {
+        CFwarn << "LAPACK: mixed precision iterative refinement not converged in " << its << " steps, factorizing in double precision." << CFendl;
+        factorization(false);
+        this->properties()["iterations"] = its;
+        return false;
+      }
+    }
+    this->properties()["iterations"] = its-1;
+    return true;
+  }
+
+  /// Verbose error message
+  static std::string err_message(const int& err) {
+    std::ostringstream msg;
+    err==-17? msg << "LAPACK: system matrix must be square." :
+    err==-42? msg << "LAPACK: precision not implemented." :
+    err<0?    msg << "LAPACK: invalid " << err << "'th argument to ?getrf_()/?getrs_()." :
+    err>0?    msg << "LAPACK: triangular factor matrix U(" << (err-1) << ',' << (err-1) << ") is zero, so A is singular (not invertible)." :
+              msg;
+    return msg.str();
+  }
+
+
  protected:
   // linear system matrix interfacing
 
@@ -123,11 +301,11 @@ class lss_API LAPACK : public linearsystem< T >
         T& A(const size_t& i, const size_t& j)       { return m_A(i,j); }
 
   /// matrix modifiers
-  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j); }
-  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); }
-  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  }
+  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j); release(); }
+  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); release(); }
+  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  release(); }
   void A___assign(const double& _value)                 { m_A = _value;   }
-  void A___clear()                                      { m_A.clear();    }
+  void A___clear()                                      { m_A.clear();    release(); }
   void A___zerorow(const size_t& i)                     { m_A.zerorow(i); }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
 
@@ -139,6 +317,14 @@ class lss_API LAPACK : public linearsystem< T >
  protected:
   // storage
   matrix_t m_A;
+  matrix_t m_LU;              // LU factorization (A is left intact)
+  std::vector< float > m_LUs; // ... or in single precision (mixed precision)
+  std::vector< int > m_ipiv;  // ... and pivot indices
+  double m_anorm;             // ... and matrix infinity norm (mixed precision)
+
+  // options
+  bool m_mixed_precision;  // if factorization is in single precision
+  int  m_mixed_maxits;     // ... maximum number of iterative refinement steps
 
 };
 
@@ -0,0 +1,164 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#include <cmath>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "TFQMR.hpp"
+
+
+namespace cf3 {
+namespace lss {
+
+
+std::string TFQMR::type_name() { return "TFQMR"; }
+common::ComponentBuilder< TFQMR, common::Component, LibLSS > Builder_TFQMR;
+
+
+TFQMR::TFQMR(const std::string& name, const size_t& _size_i, const size_t& _size_j, const size_t& _size_k)
+  : detail::ilu_solverbase(name)
+{
+  linearsystem< double >::initialize(_size_i,_size_j,_size_k);
+}
+
+
+TFQMR& TFQMR::solve()
+{
+  if (!m_A.m_size.is_square_size())
+    throw std::runtime_error("TFQMR: system matrix must be square.");
+  matrix_t::matrix_compressed_t& A = m_A.compress();
+
+  int err = 0;
+  if ((err=precondition_setup(A)))
+    throw std::runtime_error("TFQMR: " + GMRES::ilu_message(err));
+
+  // solve each right-hand side, with workspace vectors (right preconditioned,
+  // solution updated along x-space directions d^ = M^-1 d)
+  int n = static_cast< int >(size(0));
+  m_work.resize(10*n);
+  double
+    *rt  = &m_work[0],   *w   = &m_work[n],   *y1 = &m_work[2*n], *y2 = &m_work[3*n],
+    *yh1 = &m_work[4*n], *yh2 = &m_work[5*n], *u1 = &m_work[6*n], *u2 = &m_work[7*n],
+    *v   = &m_work[8*n], *dh  = &m_work[9*n];
+  int itsmax = 0;
+  double resmax = 0.;
+  bool converged = true;
+  for (size_t k=0; k<size(2); ++k) {
+    double *x = &m_x.a[k*n], *b = &m_b.a[k*n];
+
+    // (re)start from residual r = b - A x (as w, y1 and r~), u1 = v = A M^-1 y1,
+    // when the residual bound is met but not the (true) residual norm, as
+    // these can drift apart in finite precision
+    double eps = -1., res = 0.;
+    int its = 0;
+    while (true) {
+      m_A.multi(x,w,1,-1.);
+      for (int i=0; i<n; ++i)
+        w[i] += b[i];
+      res = std::sqrt(dot(n,w,w));
+      eps = (eps<0.? m_rtol*res : eps);
+      if (res<=eps || its>=m_maxits)
+        break;
+
+      std::copy(w,w+n,y1);
+      std::copy(w,w+n,rt);
+      std::fill(dh,dh+n,0.);
+      double
+        tau   = res,
+        rho   = dot(n,rt,w),
+        theta = 0.,
+        eta   = 0.,
+        bound = tau;
+      int m = 0;  // (half steps since restart)
+      precondition(n,y1,yh1);
+      m_A.multi(yh1,u1,1);
+      std::copy(u1,u1+n,v);
+
+      while (bound>eps && its<m_maxits) {
+        ++its;
+
+        // second direction y2 = y1 - alpha v, and u2 = A M^-1 y2
+        const double sigma = dot(n,rt,v);
+        if (sigma==0.)
+          throw std::runtime_error("TFQMR: breakdown (r~'v = 0), restart with a different initial guess.");
+        const double alpha = rho/sigma;
+        #pragma omp parallel for schedule(static)
+        for (int i=0; i<n; ++i)
+          y2[i] = y1[i] - alpha*v[i];
+        precondition(n,y2,yh2);
+        m_A.multi(yh2,u2,1);
+
+        // two quasi-minimal residual half steps, along y1 and y2
+        for (int j=0; j<2 && bound>eps; ++j) {
+          const double
+            *yh = (j? yh2 : yh1),
+            *u  = (j? u2  : u1 ),
+            coef = theta*theta*eta/alpha;
+          double ww = 0.;
+          #pragma omp parallel for schedule(static) reduction(+:ww)
+          for (int i=0; i<n; ++i) {
+            w[i] -= alpha*u[i];
+            dh[i] = yh[i] + coef*dh[i];
+            ww += w[i]*w[i];
+          }
+          theta = std::sqrt(ww)/tau;
+          const double c = 1./std::sqrt(1.+theta*theta);
+          tau *= theta*c;
+          eta  = c*c*alpha;
+          #pragma omp parallel for schedule(static)
+          for (int i=0; i<n; ++i)
+            x[i] += eta*dh[i];
+
+          // residual norm (upper) bound
+          bound = tau*std::sqrt(static_cast< double >(++m + 1));
+        }
+
+        if (m_monitor) {
+          CFinfo << "TFQMR: iteration/residual bound: " << its << '/' << bound;
+          if (size(2)>1)
+            CFinfo << " (rhs " << k << ')';
+          CFinfo << CFendl;
+        }
+        if (bound<=eps)
+          break;
+
+        // next directions y1 = w + beta y2, u1 = A M^-1 y1, v = u1 + beta (u2 + beta v)
+        const double rho1 = dot(n,rt,w);
+        if (rho1==0.)
+          throw std::runtime_error("TFQMR: breakdown (r~'r = 0), restart with a different initial guess.");
+        const double beta = rho1/rho;
+        rho = rho1;
+        #pragma omp parallel for schedule(static)
+        for (int i=0; i<n; ++i)
+          y1[i] = w[i] + beta*y2[i];
+        precondition(n,y1,yh1);
+        m_A.multi(yh1,u1,1);
+        #pragma omp parallel for schedule(static)
+        for (int i=0; i<n; ++i)
+          v[i] = u1[i] + beta*(u2[i] + beta*v[i]);
+      }
+    }
+
+    itsmax = std::max(itsmax,its);
+    resmax = std::max(resmax,res);
+    converged = converged && res<=eps;
+  }
+
+  properties()["iterations"] = itsmax;
+  properties()["residual"]   = resmax;
+  if (m_monitor)
+    CFinfo << "TFQMR: iterations/residual: " << itsmax << '/' << resmax << CFendl;
+  if (!converged)
+    throw std::runtime_error("TFQMR: convergence not achieved in maxits iterations.");
+
+  return *this;
+}
+
+
+}  // namespace lss
+}  // namespace cf3
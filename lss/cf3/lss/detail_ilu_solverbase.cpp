@@ -0,0 +1,59 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#include "detail_ilu_solverbase.hpp"
+
+
+namespace cf3 {
+namespace lss {
+namespace detail {
+
+
+ilu_solverbase::ilu_solverbase(const std::string& name)
+  : solverbase(name)
+{
+  // framework scripting: options
+  m_rtol    = 1.e-5;
+  m_maxits  = 500;
+  m_lfil    = 3;
+  m_monitor = false;
+  m_pc_refresh = 1;
+  m_level_scheduling = false;
+  options().add("rtol",    m_rtol   ).link_to(&m_rtol   ).mark_basic().description("relative tolerance, solving stops when ||residual||/||initial residual|| <= rtol (default 1.e-5)");
+  options().add("maxits",  m_maxits ).link_to(&m_maxits ).mark_basic().description("maximum number of iterations to perform (default 500)");
+  options().add("lfil",    m_lfil   ).link_to(&m_lfil   ).mark_basic().description("ILU(k) preconditioner level of fill, 0 for ILU(0) (default 3)");
+  options().add("monitor", m_monitor).link_to(&m_monitor).mark_basic().description("if each iteration should be printed (default false)");
+  options().add("PCRefresh", m_pc_refresh).link_to(&m_pc_refresh).mark_basic().description("recalculate preconditioner values every given number of solves, 0 for only when the matrix structure changes (default 1)");
+  options().add("LevelScheduling", m_level_scheduling).link_to(&m_level_scheduling).mark_basic().description("if preconditioner recalculation and application run in parallel, by levels of L and U factors rows (same results, default false)");
+}
+
+
+ilu_solverbase& ilu_solverbase::copy(const ilu_solverbase& _other)
+{
+  solverbase::copy(_other);
+  m_rtol    = _other.m_rtol;
+  m_maxits  = _other.m_maxits;
+  m_lfil    = _other.m_lfil;
+  m_monitor = _other.m_monitor;
+  m_pc_refresh = _other.m_pc_refresh;
+  m_level_scheduling = _other.m_level_scheduling;
+  m_pc = GMRES::workspace_t();
+  return *this;
+}
+
+
+ilu_solverbase& ilu_solverbase::swap(ilu_solverbase& _other)
+{
+  solverbase::swap(_other);
+  m_pc = _other.m_pc = GMRES::workspace_t();
+  return *this;
+}
+
+
+}  // namespace detail
+}  // namespace lss
+}  // namespace cf3
@@ -0,0 +1,73 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#ifndef cf3_lss_detail_ilu_solverbase_hpp
+#define cf3_lss_detail_ilu_solverbase_hpp
+
+
+#include "LibLSS.hpp"
+#include "GMRES.hpp"
+#include "detail_solverbase.hpp"
+
+
+namespace cf3 {
+namespace lss {
+namespace detail {
+
+
+/**
+ * @brief Right ILU(k)-preconditioned iterative solvers, with GMRES' ILU(k)
+ * preconditioner and its options (double p.)
+ */
+class lss_API ilu_solverbase : public solverbase
+{
+ public:
+  /// Construction (with options rtol, maxits, lfil, monitor, PCRefresh and
+  /// LevelScheduling)
+  ilu_solverbase(const std::string& name);
+
+  /// Linear system copy (options, the preconditioner is recalculated)
+  ilu_solverbase& copy(const ilu_solverbase& _other);
+
+  /// Linear system swap (the preconditioners are recalculated)
+  ilu_solverbase& swap(ilu_solverbase& _other);
+
+
+ protected:
+  // preconditioning
+
+  /// Preconditioner (re)calculation, returns 0 or error code (see
+  /// GMRES::ilu_message)
+  int precondition_setup(matrix_t::matrix_compressed_t& A) {
+    return GMRES::ilu(A,m_A.pattern_version(),m_lfil,m_pc_refresh,m_level_scheduling,m_pc);
+  }
+
+  /// Preconditioner application, y = M^-1 x
+  void precondition(int n, double* x, double* y) { GMRES::lusol(&n,x,y,m_pc); }
+
+
+ protected:
+  // options
+  double m_rtol;     // relative residual reduction tolerance
+  int    m_maxits;   // maximum number of iterations
+  int    m_lfil;     // ILU(k) preconditioner level of fill
+  bool   m_monitor;  // if each iteration should be printed
+  int    m_pc_refresh;        // preconditioner recalculation period (solves)
+  bool   m_level_scheduling;  // if preconditioner is level scheduled (parallel)
+
+  // storage (kept between solves): preconditioner
+  GMRES::workspace_t m_pc;
+
+};
+
+
+}  // namespace detail
+}  // namespace lss
+}  // namespace cf3
+
+
+#endif
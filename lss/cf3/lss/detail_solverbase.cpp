@@ -0,0 +1,50 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#include "detail_solverbase.hpp"
+
+
+namespace cf3 {
+namespace lss {
+namespace detail {
+
+
+solverbase::solverbase(const std::string& name)
+  : linearsystem< double >(name)
+{
+  properties().add("iterations",int(0));
+  properties().add("residual",  double(0.));
+}
+
+
+solverbase& solverbase::multi(const double& _alpha, const double& _beta)
+{
+  m_A.multi(&m_x.a[0],&m_b.a[0],size(2),_alpha,_beta);
+  return *this;
+}
+
+
+solverbase& solverbase::copy(const solverbase& _other)
+{
+  linearsystem< double >::copy(_other);
+  m_A = _other.m_A;
+  return *this;
+}
+
+
+solverbase& solverbase::swap(solverbase& _other)
+{
+  linearsystem< double >::swap(_other);
+  m_A.swap(_other.m_A);
+  m_work.swap(_other.m_work);
+  return *this;
+}
+
+
+}  // namespace detail
+}  // namespace lss
+}  // namespace cf3
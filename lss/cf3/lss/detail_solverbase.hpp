@@ -0,0 +1,81 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#ifndef cf3_lss_detail_solverbase_hpp
+#define cf3_lss_detail_solverbase_hpp
+
+
+#include "LibLSS.hpp"
+#include "linearsystem.hpp"
+
+
+namespace cf3 {
+namespace lss {
+namespace detail {
+
+
+/**
+ * @brief Sparse matrix iterative solvers management of matrix, work vectors
+ * and common operations (double p.)
+ */
+class lss_API solverbase : public linearsystem< double >
+{
+ protected:
+  // utility definitions
+  typedef sparse_matrix< double, sort_by_row, 1 > matrix_t;
+
+ public:
+  /// Construction (with properties iterations and residual)
+  solverbase(const std::string& name);
+
+  /// Linear system forward multiplication: b = alpha A x + beta b
+  solverbase& multi(const double& _alpha=1., const double& _beta=0.);
+
+  /// Linear system copy (matrix only, work vectors are not copied)
+  solverbase& copy(const solverbase& _other);
+
+  /// Linear system swap
+  solverbase& swap(solverbase& _other);
+
+
+ protected:
+  // linear system matrix interfacing
+
+  /// matrix indexing
+  const double& A(const size_t& i, const size_t& j) const { return m_A(i,j); }
+        double& A(const size_t& i, const size_t& j)       { return m_A(i,j); }
+
+  /// matrix modifiers
+  void A___initialize(const size_t& i, const size_t& j, const std::vector< std::vector< size_t > >& _nnz=std::vector< std::vector< size_t > >()) { m_A.initialize(i,j,_nnz); }
+  void A___initialize(const std::vector< double >& _vector) { m_A.initialize(_vector); }
+  void A___initialize(const std::string& _fname)            { m_A.initialize(_fname);  }
+  void A___assign(const double& _value)                 { m_A = _value;   }
+  void A___clear()                                      { m_A.clear();    }
+  void A___zerorow(const size_t& i)                     { m_A.zerorow(i); }
+  void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
+  void A___add_block(const std::vector< size_t >& _rows, const std::vector< size_t >& _cols, const std::vector< double >& _values) { m_A.add_block(_rows,_cols,_values); }
+  bool A___lock(const bool& _lock) { m_A.lock(_lock); return true; }
+
+  /// matrix inspecting
+  void   A___print(std::ostream& o, const print_t& l=print_auto) const { m_A.print(o,l); }
+  size_t A___size(const size_t& d)  const { return m_A.size(d);  }
+
+
+ protected:
+  // storage: matrix, and work vectors (kept between solves)
+  matrix_t m_A;
+  std::vector< double > m_work;
+
+};
+
+
+}  // namespace detail
+}  // namespace lss
+}  // namespace cf3
+
+
+#endif
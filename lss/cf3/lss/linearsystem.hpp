@@ -74,6 +74,14 @@ class linearsystem : public common::Action
         .description("Linear system solving, x = A^-1 b")
         .connect( boost::bind( &linearsystem::signal_solve, this ));
 
+    regist_signal("factorize")
+        .description("Linear system matrix factorization, for subsequent solve_only (direct solvers only)")
+        .connect( boost::bind( &linearsystem::signal_factorize, this ));
+
+    regist_signal("solve_only")
+        .description("Linear system solving, x = A^-1 b, reusing existing matrix factorization (direct solvers only)")
+        .connect( boost::bind( &linearsystem::signal_solve_only, this ));
+
     regist_signal("multi")
         .description("Linear system forward multiplication, b = alpha A x + beta b")
         .connect   ( boost::bind( &linearsystem::signal_multi, this, _1 ))
@@ -228,6 +236,20 @@ class linearsystem : public common::Action
 
   void signal_solve() { execute(); }
 
+  void signal_factorize() {
+    try { factorize(); }
+    catch (const std::runtime_error& e) {
+      CFwarn << "linearsystem: " << e.what() << CFendl;
+    }
+  }
+
+  void signal_solve_only() {
+    try { solve_only(); }
+    catch (const std::runtime_error& e) {
+      CFwarn << "linearsystem: " << e.what() << CFendl;
+    }
+  }
+
   void signal_multi(common::SignalArgs& args) {
     common::XML::SignalOptions opts(args);
     multi(opts.value< double >("alpha"),opts.value< double >("beta"));
@@ -366,6 +388,37 @@ class linearsystem : public common::Action
     return *this;
   }
 
+  /// Add element matrix (values in row-major order) to given rows and columns
+  /// (ignored with a warning if sizes are not consistent)
+  linearsystem& add_element(
+      const std::vector< size_t >& _rows,
+      const std::vector< size_t >& _cols,
+      const std::vector< T >& _values ) {
+    if (_values.size()!=_rows.size()*_cols.size()) {
+      CFwarn << "linearsystem: element matrix size not consistent with rows/columns, ignored." << CFendl;
+      return *this;
+    }
+    A___add_block(_rows,_cols,_values);
+    return *this;
+  }
+
+  /// Add element matrix (values in row-major order) to given rows and columns
+  /// (same indices)
+  linearsystem& add_element(
+      const std::vector< size_t >& _idx,
+      const std::vector< T >& _values ) {
+    return add_element(_idx,_idx,_values);
+  }
+
+  /// Lock (or unlock) the matrix structure for concurrent assembly: while
+  /// locked, add_element can be called from multiple threads and entries
+  /// outside the structure are ignored (only if supported by the matrix)
+  linearsystem& lock(const bool& _lock=true) {
+    if (!A___lock(_lock) && _lock)
+      CFwarn << "linearsystem: matrix structure locking not supported, add_element is not thread-safe." << CFendl;
+    return *this;
+  }
+
   /// Value assignment (method)
   linearsystem& assign(const double& _value=double()) {
     A___assign(_value);
@@ -455,6 +508,15 @@ class linearsystem : public common::Action
   /// @note: might destroy system matrix contents (structure or non-zero values)
   virtual linearsystem& solve() = 0;
 
+  /// Linear system matrix factorization, kept for subsequent solve_only
+  /// @note: only meaningful for direct solvers (default does nothing)
+  virtual linearsystem& factorize() { return *this; }
+
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization (if
+  /// not available or matrix structure changed, it is factorized first)
+  /// @note: only meaningful for direct solvers (default solves normally)
+  virtual linearsystem& solve_only() { return solve(); }
+
   /// Linear system forward multiplication: b = alpha A x + beta b
   /// @note: might should not destroy system matrix contents (structure or non-zero values)
   virtual linearsystem& multi(const double& _alpha, const double& _beta) = 0;
@@ -495,6 +557,16 @@ class linearsystem : public common::Action
   virtual void A___zerorow(const size_t& i)                     = 0;
   virtual void A___sumrows(const size_t& i, const size_t& isrc) = 0;
 
+  /// Linear system matrix block accumulation (entry by entry, unless specialized)
+  virtual void A___add_block(const std::vector< size_t >& _rows, const std::vector< size_t >& _cols, const std::vector< T >& _values) {
+    for (size_t a=0, k=0; a<_rows.size(); ++a)
+      for (size_t b=0; b<_cols.size(); ++b, ++k)
+        A(_rows[a],_cols[b]) += _values[k];
+  }
+
+  /// Linear system matrix structure locking (returns if supported)
+  virtual bool A___lock(const bool& _lock) { return false; }
+
   /// Linear system matrix inspecting
   virtual void   A___print(std::ostream& o, const print_t &l=print_auto) const = 0;
   virtual size_t A___size(const size_t& d ) const = 0;
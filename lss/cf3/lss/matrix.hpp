@@ -13,6 +13,11 @@
 #include <cmath>
 #include <iterator>
 #include <numeric>
+#include <boost/cstdint.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "common/Log.hpp"
 
@@ -611,8 +616,30 @@ struct sparse_matrix :
     std::vector< T > a;         // values
   };
 
+  // triplets (coordinate) assembly buffer, duplicates are summed on compress
+  struct matrix_triplets_t {
+    void clear() {
+      i.clear();
+      j.clear();
+      a.clear();
+    }
+    void reserve(const size_t& _n) {
+      i.reserve(_n);
+      j.reserve(_n);
+      a.reserve(_n);
+    }
+    void push_back(const size_t& _i, const size_t& _j, const T& _value) {
+      i.push_back(static_cast< int >(_i));
+      j.push_back(static_cast< int >(_j));
+      a.push_back(_value);
+    }
+    size_t size() const { return a.size(); }
+    std::vector< int > i, j;  // rows/column indices
+    std::vector< T > a;       // values
+  };
+
   // constructor
-  sparse_matrix() : matrix_base_t() {
+  sparse_matrix() : matrix_base_t(), locked(false), misses(0), hash(0), version(0) {
     if (BASE!=0 && BASE!=1)
       throw std::logic_error("sparse_matrix: indexing base should be 0 or 1.");
   }
@@ -631,6 +658,8 @@ struct sparse_matrix :
       // build (already compressed) row and column indices, and allocate values
         matu.clear();
         matc.clear();
+        matt.clear();
+        lock(false);
         matrix_base_t::m_size = idx_t(i,j);
 
         matc.nnu = static_cast< int >(_nnz.size());
@@ -644,8 +673,11 @@ struct sparse_matrix :
         for (size_t r=0, k=0; r<_nnz.size(); ++r)
           for (size_t c=0; c<_nnz[r].size(); ++c)
             matc.ja[k++] = static_cast< int >(_nnz[r][c])+BASE;
+        for (int r=0; r<matc.nnu; ++r)
+          std::sort(matc.ja.begin()+(matc.ia[r]-BASE),matc.ja.begin()+(matc.ia[r+1]-BASE));
 
         matc.a.assign(matc.nnz,T());
+        update_pattern();
 
     }
     else {
@@ -654,6 +686,8 @@ struct sparse_matrix :
       // pattern is provided
       matu.clear();
       matc.clear();
+      matt.clear();
+      lock(false);
       matrix_base_t::m_size = idx_t(i,j);
 
       for (size_t r=0; r<_nnz.size(); ++r)
@@ -684,6 +718,9 @@ struct sparse_matrix :
     matrix_base_t::clear();
     matu.clear();
     matc.clear();
+    matt.clear();
+    lock(false);
+    update_pattern();
     return *this;
   }
 
@@ -691,6 +728,8 @@ struct sparse_matrix :
     if (std::abs(_value)>1.e3*std::numeric_limits< double >::epsilon())
       CFdebug << "sparse_matrix: assigning a value only affects populated entries." << CFendl;
     const T value = static_cast< T >(_value);
+    if (matt.size())
+      compress();
     std::fill(matc.a.begin(),matc.a.end(),value);
     for (typename matrix_uncompressed_t::iterator it = matu.begin(); it!=matu.end(); ++it)
       const_cast< T& >(it->second) = value;
@@ -701,12 +740,17 @@ struct sparse_matrix :
     matrix_base_t::m_size = _other.matrix_base_t::m_size;
     matu = _other.matu;
     matc = _other.matc;
+    matt = _other.matt;
+    if (is_compressed())
+      update_pattern();  // (own version, changed only if structure differs)
     return *this;
   }
 
   sparse_matrix& zerorow(const size_t& i) {
     if (i>=matrix_base_t::m_size.i)
       throw std::runtime_error("sparse_matrix: row index out of bounds.");
+    if (matt.size())
+      compress();
     if (is_compressed()) {
       for (int k=matc.ia[i]-BASE; ORIENT && k<matc.ia[i+1]-BASE; ++k)
         matc.a[k] = T();
@@ -725,6 +769,8 @@ struct sparse_matrix :
   sparse_matrix& sumrows(const size_t& i, const size_t& isrc) {
     if (std::max(i,isrc)>=matrix_base_t::m_size.i)
       throw std::runtime_error("sparse_matrix: row index(es) outside bounds.");
+    if (matt.size())
+      compress();
 
     matrix_uncompressed_t rowu;  // (row buffer, in case matrix is compressed)
     if (is_compressed()) {
@@ -756,12 +802,9 @@ struct sparse_matrix :
     }
     else if (ORIENT) {
       // compressed & sorted by row
-      for (int i=0; i<matc.nnu; ++i)
-        for (int k=matc.ia[i]-BASE; k<matc.ia[i+1]-BASE; ++k)
-          if (matc.ja[k]-BASE==j) {
-            s += matc.a[k];
-            break;
-          }
+      for (int i=0, k; i<matc.nnu; ++i)
+        if ((k=find(i,j))>=0)
+          s += matc.a[k];
     }
     else {
       // compressed & sorted by column
@@ -784,13 +827,10 @@ struct sparse_matrix :
     }
     else if (ORIENT) {
       // compressed & sorted by row
-      for (int i=0; i<matc.nnu; ++i)
-        for (int k=matc.ia[i]-BASE; k<matc.ia[i+1]-BASE; ++k)
-          if (matc.ja[k]-BASE==j) {
-            n = (inf? std::max(std::abs( matc.a[k] ), std::abs( n ))
-                    : std::pow(std::abs( matc.a[k] ), std::abs( q )) + n);
-            break;
-          }
+      for (int i=0, k; i<matc.nnu; ++i)
+        if ((k=find(i,j))>=0)
+          n = (inf? std::max(std::abs( matc.a[k] ), std::abs( n ))
+                  : std::pow(std::abs( matc.a[k] ), std::abs( q )) + n);
     }
     else {
       // compressed & sorted by column
@@ -807,6 +847,9 @@ struct sparse_matrix :
     matrix_base_t::swap(_other);
     std::swap(matu,_other.matu);
     std::swap(matc,_other.matc);
+    std::swap(matt,_other.matt);
+    update_pattern();
+    _other.update_pattern();
     return *this;
   }
 
@@ -822,6 +865,13 @@ struct sparse_matrix :
     if (lvl==print_size)  {
       o << "(" << size.i << 'x' << size.j << ">=" << (matc.nnz+matu.size()) << ") [ ... ]";
     }
+    else if (matt.size()) {
+
+      // (requires assembled triplets, so print an assembled copy)
+      sparse_matrix tmp(*this);
+      tmp.compress();
+      tmp.print(o,lvl);
+    }
     else {
 
       // (requires an uncompressed structure)
@@ -894,12 +944,9 @@ struct sparse_matrix :
       return matrix_base_t::m_zero;
     }
     if (is_compressed()) {
-      for (int k=matc.ia[i]-BASE; is_compressed() && ORIENT && k<matc.ia[i+1]-BASE; ++k)
-        if (matc.ja[k]-BASE==(int) j)
-          return matc.a[k];
-      for (int k=matc.ja[j]-BASE; is_compressed() && !ORIENT && k<matc.ja[j+1]-BASE; ++k)
-        if (matc.ia[k]-BASE==(int) i)
-          return matc.a[k];
+      const int k = find(i,j);
+      if (k>=0)
+        return matc.a[k];
     }
     else {
       typename matrix_uncompressed_t::const_iterator it = matu.find(coord_t<T>(idx_t(i,j),T()));
@@ -915,13 +962,22 @@ struct sparse_matrix :
       CFwarn << "sparse_matrix: index not available, (" << i << ',' << j << ") >= (" << matrix_base_t::m_size.i << ',' << matrix_base_t::m_size.j << ")." << CFendl;
       return matrix_base_t::m_zero;
     }
+    if (matt.size())
+      compress();
     if (is_compressed()) {
-      for (int k=matc.ia[i]-BASE; ORIENT && k<matc.ia[i+1]-BASE; ++k)
-        if (matc.ja[k]-BASE==(int) j)
-          return matc.a[k];
-      for (int k=matc.ja[j]-BASE; !ORIENT && k<matc.ja[j+1]-BASE; ++k)
-        if (matc.ia[k]-BASE==(int) i)
-          return matc.a[k];
+      const int k = find(i,j);
+      if (k>=0)
+        return matc.a[k];
+    }
+    if (locked) {
+      // (writes to a per-thread scratch value, discarded)
+      #pragma omp atomic
+      ++misses;
+      int thread = 0;
+#ifdef _OPENMP
+      thread = std::min(omp_get_thread_num(),static_cast< int >(scratch.size())-1);
+#endif
+      return (scratch[thread] = T());
     }
     // find/insert new entry, and structurally symmetric pair. the constness
     // removal is safe because the entry value does not change matrix ordering
@@ -934,22 +990,221 @@ struct sparse_matrix :
   }
 
 
+  // assembly (accumulation of entries as triplets)
+
+  /// Add value to entry, appending a triplet to the assembly buffer (summed on
+  /// compression) unless the entry already exists in the compressed structure.
+  /// @note: pending triplets are not visible to (const) indexing before compress()
+  sparse_matrix& add(const size_t& i, const size_t& j, const T& _value) {
+    if (i>=matrix_base_t::m_size.i || j>=matrix_base_t::m_size.j) {
+      CFwarn << "sparse_matrix: index not available, (" << i << ',' << j << ") >= (" << matrix_base_t::m_size.i << ',' << matrix_base_t::m_size.j << ")." << CFendl;
+      return *this;
+    }
+    const int k = (is_compressed()? find(i,j) : -1);
+    if (k>=0 && locked)
+      atomic_add(matc.a[k],_value);
+    else if (k>=0)
+      matc.a[k] += _value;
+    else if (locked) {
+      #pragma omp atomic
+      ++misses;
+    }
+    else
+      matt.push_back(i,j,_value);
+    return *this;
+  }
+
+  /// Add dense block (values in row-major order) to entries at given rows and
+  /// columns: if compressed, each row is swept once against the (sorted) block
+  /// columns to accumulate in place, otherwise the block is appended as triplets
+  /// @note: blocks with inconsistent size or indices outside bounds are ignored
+  /// (with a warning, as add(), so it is safe to call in parallel regions)
+  sparse_matrix& add_block(
+      const std::vector< size_t >& _rows,
+      const std::vector< size_t >& _cols,
+      const std::vector< T >& _values ) {
+    const size_t
+      nr(_rows.size()),
+      nc(_cols.size());
+    if (_values.size()!=nr*nc) {
+      CFwarn << "sparse_matrix: block size not consistent with rows/columns, " << _values.size() << " != " << nr << 'x' << nc << "." << CFendl;
+      return *this;
+    }
+    for (size_t a=0; a<nr; ++a)
+      if (_rows[a]>=matrix_base_t::m_size.i) {
+        CFwarn << "sparse_matrix: block row index not available, " << _rows[a] << " >= " << matrix_base_t::m_size.i << "." << CFendl;
+        return *this;
+      }
+    for (size_t b=0; b<nc; ++b)
+      if (_cols[b]>=matrix_base_t::m_size.j) {
+        CFwarn << "sparse_matrix: block column index not available, " << _cols[b] << " >= " << matrix_base_t::m_size.j << "." << CFendl;
+        return *this;
+      }
+
+    if (!is_compressed() && locked) {
+      #pragma omp atomic
+      misses += nr*nc;
+      return *this;
+    }
+    else if (!is_compressed()) {
+      matt.reserve(matt.size()+nr*nc);
+      for (size_t a=0, k=0; a<nr; ++a)
+        for (size_t b=0; b<nc; ++b, ++k)
+          matt.push_back(_rows[a],_cols[b],_values[k]);
+      return *this;
+    }
+
+    // block major (compressed rows, or columns) and sorted minor indices
+    const std::vector< size_t >
+      &maj(ORIENT? _rows:_cols),
+      &mnr(ORIENT? _cols:_rows);
+    const std::vector< int >
+      &p(ORIENT? matc.ia:matc.ja),
+      &x(ORIENT? matc.ja:matc.ia);
+    std::vector< std::pair< int, int > > sorted(mnr.size());
+    for (size_t b=0; b<mnr.size(); ++b)
+      sorted[b] = std::pair< int, int >(static_cast< int >(mnr[b])+BASE,static_cast< int >(b));
+    std::sort(sorted.begin(),sorted.end());
+
+    for (size_t a=0; a<maj.size(); ++a) {
+      const int r(static_cast< int >(maj[a]));
+      int k = p[r]-BASE;
+      const int last = p[r+1]-BASE;
+      for (size_t b=0; b<sorted.size(); ++b) {
+        const int s(sorted[b].first);
+        const size_t v(ORIENT? a*nc+sorted[b].second : sorted[b].second*nc+a);
+        while (k<last && x[k]<s)
+          ++k;
+        if (k<last && x[k]==s && locked)
+          atomic_add(matc.a[k],_values[v]);
+        else if (k<last && x[k]==s)
+          matc.a[k] += _values[v];
+        else if (locked) {
+          #pragma omp atomic
+          ++misses;
+        }
+        else
+          matt.push_back(_rows[ORIENT? a:sorted[b].second],_cols[ORIENT? sorted[b].second:a],_values[v]);
+      }
+    }
+    return *this;
+  }
+
+  /// Lock (or unlock) the compressed structure for concurrent assembly: while
+  /// locked, add() and add_block() accumulate atomically and can be called from
+  /// multiple threads, and entries outside the structure are counted (and
+  /// reported on unlock) instead of changing the structure (indexing them
+  /// returns a per-thread scratch value, which is discarded)
+  sparse_matrix& lock(const bool& _lock=true) {
+    if (_lock && !locked) {
+      compress();
+      misses = 0;
+      int nthreads = 1;
+#ifdef _OPENMP
+      nthreads = omp_get_max_threads();
+#endif
+      scratch.assign(nthreads,T());
+    }
+    else if (!_lock && misses) {
+      CFwarn << "sparse_matrix: entries outside locked structure (ignored): " << misses << CFendl;
+    }
+    locked = _lock;
+    return *this;
+  }
+
+  /// Number of entries outside locked structure (since locking)
+  size_t lock_misses() const { return misses; }
+
+  /// Structure version, changing only when compression results in a different
+  /// structure (so solvers can skip symbolic work if only values changed)
+  size_t pattern_version() const { return version; }
+
+  /// Reserve assembly buffer for a given number of triplets
+  sparse_matrix& reserve(const size_t& _ntriplets) {
+    matt.reserve(_ntriplets);
+    return *this;
+  }
+
+
+  // products
+
+  /// Sparse matrix by dense vectors product, y = alpha A x + beta y, for k
+  /// vectors stored contiguously (x and y column-major, with size(1) and
+  /// size(0) rows respectively; y is overwritten if beta is zero). If sorted
+  /// by row, rows are split among threads by balanced number of non-zeros,
+  /// and vectors are processed in blocks of up to four so that each block
+  /// sweeps the matrix only once
+  sparse_matrix& multi(const T* x, T* y, const size_t& k=1, const T& alpha=T(1), const T& beta=T()) {
+    compress();
+    const size_t
+      ldx = matrix_base_t::m_size.j,
+      ldy = matrix_base_t::m_size.i;
+
+    if (!ORIENT) {
+      // column-oriented: scatter per column (sequential)
+      for (size_t c=0; c<k; ++c) {
+        T *yc = y+c*ldy;
+        for (size_t i=0; i<ldy; ++i)
+          yc[i] = (beta==T()? T() : beta*yc[i]);
+        for (int j=0; j<matc.nnu; ++j) {
+          const T xj = alpha*x[c*ldx+j];
+          for (int l=matc.ja[j]-BASE; l<matc.ja[j+1]-BASE; ++l)
+            yc[matc.ia[l]-BASE] += matc.a[l]*xj;
+        }
+      }
+      return *this;
+    }
+
+    #pragma omp parallel
+    {
+      int nthreads = 1, thread = 0;
+#ifdef _OPENMP
+      nthreads = omp_get_num_threads();
+      thread   = omp_get_thread_num();
+#endif
+      const int
+        r0 = partition(thread,  nthreads),
+        r1 = partition(thread+1,nthreads);
+      for (size_t c=0; c<k; c+=4) {
+        switch (std::min< size_t >(4,k-c)) {
+          case 4:  multi_rows< 4 >(r0,r1,x+c*ldx,ldx,y+c*ldy,ldy,alpha,beta); break;
+          case 3:  multi_rows< 3 >(r0,r1,x+c*ldx,ldx,y+c*ldy,ldy,alpha,beta); break;
+          case 2:  multi_rows< 2 >(r0,r1,x+c*ldx,ldx,y+c*ldy,ldy,alpha,beta); break;
+          default: multi_rows< 1 >(r0,r1,x+c*ldx,ldx,y+c*ldy,ldy,alpha,beta); break;
+        }
+      }
+    }
+    return *this;
+  }
+
+
   // compression/uncompression
 
   matrix_compressed_t& compress() {
-    if (!is_compressed()) {
+    if (matt.size()) {
+      CFinfo << "sparse_matrix::compress (triplets: " << matt.size() << ")..." << CFendl;
+      compress(matrix_base_t::m_size,matu,matc,matt);
+      matu.clear();
+      matt.clear();
+      update_pattern();
+      CFinfo << "sparse_matrix::compress." << CFendl;
+    }
+    else if (!is_compressed()) {
       CFinfo << "sparse_matrix::compress..." << CFendl;
       const size_t nmodif = ensure_structural_symmetry(matrix_base_t::m_size,matu);
       if (nmodif)
         CFinfo << "sparse_matrix: symmetry preserving additional entries: " << nmodif << CFendl;
       compress(matrix_base_t::m_size,matu,matc);
       matu.clear();
+      update_pattern();
       CFinfo << "sparse_matrix::compress." << CFendl;
     }
     return matc;
   }
 
   matrix_uncompressed_t& uncompress() {
+    if (matt.size())
+      compress();
     if (is_compressed()) {
       CFinfo << "sparse_matrix::uncompress..." << CFendl;
       uncompress(matrix_base_t::m_size,matu,matc);
@@ -968,6 +1223,106 @@ struct sparse_matrix :
 
   inline bool is_compressed() const { return matc.nnz; }
 
+  /// Update structure version if the compressed structure changed: size and
+  /// row (or column) pointers are compared exactly (a copy is kept), and
+  /// column (or row) indices by hash (64-bit FNV-1a, on the index bytes)
+  void update_pattern() {
+    const boost::uint64_t
+      prime = (static_cast< boost::uint64_t >(1u) << 40) + 0x1b3u,                // 1099511628211
+      basis = (static_cast< boost::uint64_t >(0xcbf29ce4u) << 32) + 0x84222325u;  // 14695981039346656037
+    boost::uint64_t h = basis;
+    const unsigned char
+      *b = reinterpret_cast< const unsigned char* >(matc.ja.empty()? NULL : &matc.ja[0]),
+      *e = b + matc.ja.size()*sizeof(int);
+    for (; b!=e; ++b)
+      h = (h ^ static_cast< boost::uint64_t >(*b)) * prime;
+    if (!version || h!=hash || matrix_base_t::m_size!=pattern_size || matc.ia!=pattern_ia) {
+      hash = h;
+      pattern_size = matrix_base_t::m_size;
+      pattern_ia   = matc.ia;
+      ++version;
+    }
+  }
+
+  /// First row of a partition (of a number of partitions) of the compressed
+  /// (row-oriented) matrix, balancing the number of non-zeros per partition
+  inline int partition(const int& p, const int& np) const {
+    if (p>=np)
+      return matc.nnu;
+    const int first = BASE + static_cast< int >((static_cast< double >(matc.nnz)*p)/np);
+    return static_cast< int >(std::lower_bound(matc.ia.begin(),matc.ia.begin()+matc.nnu,first) - matc.ia.begin());
+  }
+
+  /// Sparse matrix by dense vectors product over a range of rows, for a block
+  /// of NC vectors: each row is swept once, accumulating all vectors (single
+  /// vectors use independent partial sums, so the inner product vectorizes)
+  template< int NC >
+  void multi_rows(const int& r0, const int& r1, const T* x, const size_t& ldx, T* y, const size_t& ldy, const T& alpha, const T& beta) const {
+    const int *ia = &matc.ia[0], *ja = &matc.ja[0];
+    const T *a = &matc.a[0];
+    for (int r=r0; r<r1; ++r) {
+      const int lb = ia[r]-BASE, le = ia[r+1]-BASE;
+      T t[NC];
+      if (NC==1) {
+        T t0 = T(), t1 = T(), t2 = T(), t3 = T();
+        int l = lb;
+        for (; l+3<le; l+=4) {
+          t0 += a[l  ]*x[ja[l  ]-BASE];
+          t1 += a[l+1]*x[ja[l+1]-BASE];
+          t2 += a[l+2]*x[ja[l+2]-BASE];
+          t3 += a[l+3]*x[ja[l+3]-BASE];
+        }
+        for (; l<le; ++l)
+          t0 += a[l]*x[ja[l]-BASE];
+        t[0] = (t0+t1)+(t2+t3);
+      }
+      else {
+        for (int c=0; c<NC; ++c)
+          t[c] = T();
+        for (int l=lb; l<le; ++l) {
+          const T v = a[l];
+          const int j = ja[l]-BASE;
+          for (int c=0; c<NC; ++c)
+            t[c] += v*x[c*ldx+j];
+        }
+      }
+      for (int c=0; c<NC; ++c)
+        y[c*ldy+r] = (beta==T()? alpha*t[c] : alpha*t[c] + beta*y[c*ldy+r]);
+    }
+  }
+
+  /// Position of entry in compressed structure (or -1 if not found), searching
+  /// the sorted row (or column) indices: short rows are scanned by counting
+  /// the smaller indices (no branches, vectorizes) and longer rows are bisected
+  /// without branches, so lookup costs O(log row_nnz)
+  inline int find(const size_t& i, const size_t& j) const {
+    const std::vector< int >
+      &p(ORIENT? matc.ia:matc.ja),
+      &x(ORIENT? matc.ja:matc.ia);
+    const int
+      r(static_cast< int >(ORIENT? i:j)),
+      s(static_cast< int >(ORIENT? j:i)+BASE),
+      first(p[r]-BASE),
+      len  (p[r+1]-p[r]);
+    if (len<=0)
+      return -1;
+
+    const int *base = &x[first];
+    int k = 0;
+    if (len<=16) {
+      for (int l=0; l<len; ++l)
+        k += (base[l]<s);
+    }
+    else {
+      for (int n=len, half; n>1; n-=half) {
+        half = n/2;
+        base += (base[half]<s? half:0);
+      }
+      k = static_cast< int >(base-&x[first]) + (*base<s);
+    }
+    return (k<len && x[first+k]==s? first+k : -1);
+  }
+
   static void compress(
     const idx_t& _size,
     const matrix_uncompressed_t & _u,
@@ -1015,6 +1370,107 @@ struct sparse_matrix :
   }
 
 
+  static void compress(
+    const idx_t& _size,
+    const matrix_uncompressed_t& _u,
+    matrix_compressed_t& _c,
+    const matrix_triplets_t& _t)
+  {
+    // merge compressed/uncompressed structure, triplets and their structurally
+    // symmetric pairs and the diagonal, by counting sort on the row (or column
+    // if column-oriented), followed by sorting and summing duplicates per row
+    typedef std::pair< int, T > entry_t;
+    const int nnu = static_cast< int >(ORIENT? _size.i:_size.j);
+    const int ndiag = static_cast< int >(std::min(_size.i,_size.j));
+    const std::vector< int >
+      &cp(ORIENT? _c.ia:_c.ja),  // (compressed pointers)
+      &ci(ORIENT? _c.ja:_c.ia);  // (compressed indices)
+
+    std::vector< int > ptr(nnu+2,0);
+    std::vector< entry_t > e;
+    for (int pass=0; pass<2; ++pass) {
+      int *p = (pass? &ptr[1] : &ptr[2]);
+      if (pass) {
+        for (int r=0; r<nnu; ++r)
+          ptr[r+2] += ptr[r+1];
+        e.resize(ptr[nnu+1]);
+      }
+      for (int r=0; r<_c.nnu; ++r)
+        for (int k=cp[r]-BASE; k<cp[r+1]-BASE; ++k)
+          put(pass,p,e,r,ci[k]-BASE,_c.a[k]);
+      for (typename matrix_uncompressed_t::const_iterator it=_u.begin(); it!=_u.end(); ++it)
+        put(pass,p,e,
+          static_cast< int >(ORIENT? it->first.i:it->first.j),
+          static_cast< int >(ORIENT? it->first.j:it->first.i), it->second );
+      for (size_t k=0; k<_t.size(); ++k) {
+        const int
+          r(ORIENT? _t.i[k]:_t.j[k]),
+          s(ORIENT? _t.j[k]:_t.i[k]);
+        put(pass,p,e,r,s,_t.a[k]);
+        if (r!=s && s<nnu && r<static_cast< int >(ORIENT? _size.j:_size.i))
+          put(pass,p,e,s,r,T());
+      }
+      for (int d=0; d<ndiag; ++d)
+        put(pass,p,e,d,d,T());
+    }
+
+    // sort each row by column and sum duplicates (rows are independent)
+    std::vector< int > count(nnu+1,0);
+    #pragma omp parallel for schedule(dynamic,1024)
+    for (int r=0; r<nnu; ++r) {
+      typename std::vector< entry_t >::iterator
+        first(e.begin()+ptr[r]),
+        last (e.begin()+ptr[r+1]);
+      std::sort(first,last,sort_entry_t());
+      typename std::vector< entry_t >::iterator u(first);
+      for (typename std::vector< entry_t >::iterator it=first; it!=last; ++it) {
+        if (u!=it && u->first==it->first)
+          u->second += it->second;
+        else if (u!=it)
+          *(++u) = *it;
+      }
+      count[r+1] = (first==last? 0 : static_cast< int >(u-first)+1);
+    }
+
+    _c.clear();
+    for (int r=0; r<nnu; ++r)
+      count[r+1] += count[r];
+    if (!count[nnu])
+      return;
+
+    std::vector< int >
+      &op(ORIENT? _c.ia:_c.ja),  // (output pointers)
+      &oi(ORIENT? _c.ja:_c.ia);  // (output indices)
+    _c.nnu = nnu;
+    _c.nnz = count[nnu];
+    op.resize(nnu+1);
+    oi.resize(_c.nnz);
+    _c.a.resize(_c.nnz);
+    #pragma omp parallel for schedule(dynamic,1024)
+    for (int r=0; r<nnu; ++r) {
+      op[r] = count[r]+BASE;
+      for (int k=count[r], l=ptr[r]; k<count[r+1]; ++k, ++l) {
+        oi  [k] = e[l].first+BASE;
+        _c.a[k] = e[l].second;
+      }
+    }
+    op[nnu] = count[nnu]+BASE;
+  }
+
+
+  static inline void put(const int& pass, int *p, std::vector< std::pair< int, T > >& e, const int& r, const int& s, const T& v) {
+    if (pass) e[p[r]++] = std::pair< int, T >(s,v);
+    else      ++p[r];
+  }
+
+
+  struct sort_entry_t {
+    bool operator()(const std::pair< int, T >& a, const std::pair< int, T >& b) const {
+      return a.first<b.first;
+    }
+  };
+
+
   static void uncompress(
       const idx_t& _size,
       matrix_uncompressed_t & _u,
@@ -1059,6 +1515,14 @@ struct sparse_matrix :
   // storage
   matrix_uncompressed_t matu;  // (uncompressed, in 0-based indexing)
   matrix_compressed_t   matc;  // (compressed, in BASE indexing)
+  matrix_triplets_t     matt;  // (assembly triplets, in 0-based indexing)
+  bool   locked;               // (structure locked for concurrent assembly)
+  size_t misses;               // (... entries outside structure, if locked)
+  boost::uint64_t hash;        // (compressed structure indices hash,
+  idx_t pattern_size;          // ... size,
+  std::vector< int > pattern_ia;  // ... pointers,
+  size_t version;              // ... and version, changing with any of these)
+  std::vector< T > scratch;    // (per-thread values for indexing outside locked structure)
 
 };
 
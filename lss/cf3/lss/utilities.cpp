@@ -19,6 +19,18 @@ namespace cf3 {
 namespace lss {
 
 
+/* -- generic utilities ----------------------------------------------------- */
+
+double dot(const int& n, const double* x, const double* y)
+{
+  double s = 0.;
+  #pragma omp parallel for schedule(static) reduction(+:s)
+  for (int i=0; i<n; ++i)
+    s += x[i]*y[i];
+  return s;
+}
+
+
 /* -- MatrixMarket I/O helper structures ------------------------------------ */
 
 namespace MatrixMarket {
@@ -76,6 +76,29 @@ struct type_conversion_t
 };
 
 
+/// @brief Atomic accumulation (for concurrent assembly, using OpenMP if available)
+inline void atomic_add(double& a, const double& v) {
+  #pragma omp atomic
+  a += v;
+}
+
+inline void atomic_add(float& a, const float& v) {
+  #pragma omp atomic
+  a += v;
+}
+
+template< typename R >
+inline void atomic_add(std::complex< R >& a, const std::complex< R >& v) {
+  R *p = reinterpret_cast< R* >(&a);  // (real and imaginary parts are contiguous)
+  atomic_add(p[0],v.real());
+  atomic_add(p[1],v.imag());
+}
+
+
+/// @brief Dot product of vectors of length n (using OpenMP if available)
+double dot(const int& n, const double* x, const double* y);
+
+
 /// @brief Indexing base conversion tool (functor)
 struct base_conversion_t
 {
@@ -15,6 +15,8 @@ solvers = [
   'LAPACK_LongPrecisionReal',
   'LAPACK_ShortPrecisionReal',
   'GMRES',
+  'BiCGStab',
+  'TFQMR',
   'pardiso.pardiso',
   'mkl.dss',
   'mkl.pardiso',
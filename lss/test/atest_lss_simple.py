@@ -15,6 +15,9 @@ list_of_solvers = [
   'GaussianElimination',
   'GaussianElimination_SinglePrecision',
   'GMRES',
+  'BiCGStab',
+  'TFQMR',
+  'AMG',
   'Dlib',
   'Dlib_SinglePrecision',
   'petsc.petsc_seq',
@@ -0,0 +1,41 @@
+#!/usr/bin/python
+
+
+import coolfluid as cf
+
+
+cf.env.log_level = 3 #  1=error, 2=warning, 3=info, 4=debug
+
+
+# symmetric positive definite system (1D Laplacian), expected solution:
+#   x = [ 1 2 3 4 ; 2 4 6 8 ]
+list_of_solvers = [
+  ('LAPACK',            ''),
+  ('CG',                'none'),
+  ('CG',                'jacobi'),
+  ('CG',                'ic0'),
+  ('CG',                'ssor'),
+  ('AMG',               ''),
+  ('GMRES',             'amg'),
+  ]
+for (solver,pc) in list_of_solvers:
+  lss = cf.root.create_component('MySolver_' + solver + pc,'cf3.lss.' + solver)
+  if len(pc): lss.PCType = pc
+  if solver=='AMG': lss.coarse = 2  # (two levels, instead of solving directly)
+
+
+  print solver, pc
+  lss.initialize(i=4,j=4,k=2)
+  lss.A = [  2, -1,  0,  0,
+            -1,  2, -1,  0,
+             0, -1,  2, -1,
+             0,  0, -1,  2 ]
+  lss.b = [  0,  0,
+             0,  0,
+             0,  0,
+             5, 10 ]
+  lss.solve()
+  lss.output(A=1,b=1,x=3)
+
+  lss.delete_component()
+
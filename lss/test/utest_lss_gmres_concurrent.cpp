@@ -0,0 +1,130 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::lss GMRES concurrent solving"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/bind.hpp>
+
+#include "common/Component.hpp"
+#include "cf3/lss/GMRES.hpp"
+
+
+using namespace cf3;
+
+
+namespace {
+
+
+const size_t nsystems = 8;
+const size_t n        = 20000;
+
+
+/// Assemble a (non-symmetric, tridiagonal) system, with right-hand side
+/// depending on the system number
+void assemble(lss::GMRES& lss, const size_t& s)
+{
+  std::vector< std::vector< size_t > > nnz(n);
+  for (size_t i=0; i<n; ++i)
+    for (size_t j=(i? i-1:0); j<std::min(n,i+2); ++j)
+      nnz[i].push_back(j);
+  lss.initialize(n,n,1,nnz);
+
+  std::vector< size_t > r(1), c(1);
+  std::vector< double > v(1);
+  for (size_t i=0; i<n; ++i) {
+    for (size_t j=(i? i-1:0); j<std::min(n,i+2); ++j) {
+      r[0] = i;
+      c[0] = j;
+      v[0] = (i==j? 2.2 : (j<i? -1.5 : -0.5));
+      lss.add_element(r,c,v);
+    }
+    lss.b(i) = 1. + static_cast< double >(s) + static_cast< double >(i%7);
+  }
+}
+
+
+/// Solve a system (thread function, all starting together), flagging failure
+void solve(lss::GMRES* lss, boost::barrier* start, bool* ok)
+{
+  start->wait();
+  try {
+    lss->solve();
+    *ok = true;
+  }
+  catch (...) {
+    *ok = false;
+  }
+}
+
+
+}  // namespace
+
+
+BOOST_AUTO_TEST_SUITE( lss_gmres_concurrent )
+
+
+BOOST_AUTO_TEST_CASE( bit_identical_concurrent_solves )
+{
+  std::vector< boost::shared_ptr< lss::GMRES > > serial, concurrent;
+  for (size_t s=0; s<nsystems; ++s) {
+    serial    .push_back(common::allocate_component< lss::GMRES >("serial"));
+    concurrent.push_back(common::allocate_component< lss::GMRES >("concurrent"));
+    assemble(*serial[s],s);
+    assemble(*concurrent[s],s);
+  }
+
+  // reference (serial) solutions
+  for (size_t s=0; s<nsystems; ++s)
+    BOOST_REQUIRE_NO_THROW( serial[s]->solve() );
+
+  // concurrent solutions
+  bool ok[nsystems];
+  boost::barrier start(nsystems);
+  boost::thread_group threads;
+  for (size_t s=0; s<nsystems; ++s)
+    threads.create_thread(boost::bind(&solve,concurrent[s].get(),&start,&ok[s]));
+  threads.join_all();
+
+  for (size_t s=0; s<nsystems; ++s) {
+    BOOST_CHECK( ok[s] );
+    size_t ndiff = 0;
+    for (size_t i=0; i<n; ++i)
+      ndiff += (serial[s]->x(i)!=concurrent[s]->x(i)? 1:0);
+    BOOST_CHECK_EQUAL( ndiff, size_t(0) );
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE( bit_identical_level_scheduled_solves )
+{
+  boost::shared_ptr< lss::GMRES >
+    sequential     = common::allocate_component< lss::GMRES >("sequential"),
+    levelscheduled = common::allocate_component< lss::GMRES >("levelscheduled");
+  levelscheduled->options().set("LevelScheduling",true);
+
+  // first solve calculates the preconditioner structure, second only values
+  for (size_t s=0; s<2; ++s) {
+    assemble(*sequential,s);
+    assemble(*levelscheduled,s);
+    BOOST_REQUIRE_NO_THROW( sequential->solve() );
+    BOOST_REQUIRE_NO_THROW( levelscheduled->solve() );
+
+    size_t ndiff = 0;
+    for (size_t i=0; i<n; ++i)
+      ndiff += (sequential->x(i)!=levelscheduled->x(i)? 1:0);
+    BOOST_CHECK_EQUAL( ndiff, size_t(0) );
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
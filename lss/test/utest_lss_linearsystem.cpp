@@ -0,0 +1,153 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::lss linearsystem"
+
+#include <algorithm>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Component.hpp"
+#include "cf3/lss/GaussianElimination.hpp"
+#include "cf3/lss/GMRES.hpp"
+#include "cf3/lss/LAPACK.hpp"
+#include "utest_lss_solve_only.hpp"
+
+
+using namespace cf3;
+
+
+namespace {
+
+
+const size_t m = 4;            // mesh cells per direction
+const size_t n = (m+1)*(m+1);  // ... and nodes
+
+
+/// Mesh element (quadrilateral) nodes
+std::vector< size_t > element_nodes(const size_t& e)
+{
+  const size_t i = e/m, j = e%m;
+  std::vector< size_t > nodes(4);
+  nodes[0] = i*(m+1) + j;
+  nodes[1] = nodes[0] + 1;
+  nodes[2] = nodes[1] + m+1;
+  nodes[3] = nodes[0] + m+1;
+  return nodes;
+}
+
+
+/// Mesh element matrix (non-symmetric, row-major)
+std::vector< double > element_matrix(const size_t& e)
+{
+  std::vector< double > values(16);
+  for (size_t a=0; a<4; ++a)
+    for (size_t b=0; b<4; ++b)
+      values[a*4+b] = (a==b? 4. : -1.) + 0.125*static_cast< double >(e%5) + 0.25*static_cast< double >(a) - 0.0625*static_cast< double >(b);
+  return values;
+}
+
+
+/// Matrix non-zero pattern (node connectivity)
+std::vector< std::vector< size_t > > mesh_pattern()
+{
+  std::vector< std::vector< size_t > > nnz(n);
+  for (size_t e=0; e<m*m; ++e) {
+    const std::vector< size_t > nodes(element_nodes(e));
+    for (size_t a=0; a<4; ++a)
+      for (size_t b=0; b<4; ++b)
+        if (std::find(nnz[nodes[a]].begin(),nnz[nodes[a]].end(),nodes[b])==nnz[nodes[a]].end())
+          nnz[nodes[a]].push_back(nodes[b]);
+  }
+  return nnz;
+}
+
+
+/// Assemble the mesh by element blocks, or entry by entry
+void assemble(lss::linearsystem< double >& lss, const bool& by_element)
+{
+  for (size_t e=0; e<m*m; ++e) {
+    const std::vector< size_t > nodes(element_nodes(e));
+    const std::vector< double > values(element_matrix(e));
+    if (by_element)
+      lss.add_element(nodes,values);
+    else
+      for (size_t a=0; a<4; ++a)
+        for (size_t b=0; b<4; ++b)
+          lss.A(nodes[a],nodes[b]) += values[a*4+b];
+  }
+}
+
+
+}  // namespace
+
+
+BOOST_AUTO_TEST_SUITE( lss_linearsystem )
+
+
+BOOST_AUTO_TEST_CASE( add_element )
+{
+  const std::vector< std::vector< size_t > > nnz(mesh_pattern());
+
+  // reference: entry by entry, on the sparse matrix
+  boost::shared_ptr< lss::GMRES > reference = common::allocate_component< lss::GMRES >("reference");
+  reference->initialize(n,n,1,nnz);
+  assemble(*reference,false);
+
+  // by element blocks: default (dense, through entry indexing) and sparse
+  // matrix block additions, on an existing or a new structure (triplets)
+  boost::shared_ptr< lss::LAPACK< double > > dense = common::allocate_component< lss::LAPACK< double > >("dense");
+  boost::shared_ptr< lss::GMRES >
+    structured = common::allocate_component< lss::GMRES >("structured"),
+    triplets   = common::allocate_component< lss::GMRES >("triplets");
+  dense     ->initialize(n,n,1);
+  structured->initialize(n,n,1,nnz);
+  triplets  ->initialize(n,n,1);
+  assemble(*dense,     true);
+  assemble(*structured,true);
+  assemble(*triplets,  true);
+
+  // (non-const indexing compresses pending triplets, const indexing does not)
+  const lss::linearsystem< double >
+    &R(*reference),
+    &D(*dense),
+    &S(*structured);
+  lss::linearsystem< double >& T(*triplets);
+  size_t nd = 0, ns = 0, nt = 0;
+  double sum = 0.;
+  for (size_t i=0; i<n; ++i) {
+    for (size_t k=0; k<nnz[i].size(); ++k) {
+      const size_t j = nnz[i][k];
+      nd += (R.A(i,j)!=D.A(i,j)? 1:0);
+      ns += (R.A(i,j)!=S.A(i,j)? 1:0);
+      nt += (R.A(i,j)!=T.A(i,j)? 1:0);
+      sum += D.A(i,j);
+    }
+  }
+  BOOST_CHECK_EQUAL( nd, size_t(0) );
+  BOOST_CHECK_EQUAL( ns, size_t(0) );
+  BOOST_CHECK_EQUAL( nt, size_t(0) );
+
+  // entries outside the pattern are not touched (dense matrix)
+  double dsum = 0.;
+  for (size_t i=0; i<n; ++i)
+    for (size_t j=0; j<n; ++j)
+      dsum += D.A(i,j);
+  BOOST_CHECK_EQUAL( dsum, sum );
+}
+
+
+BOOST_AUTO_TEST_CASE( factorize_solve_only )
+{
+  utest::check_solve_only< lss::LAPACK< double > >();
+  utest::check_solve_only< lss::GaussianElimination< double > >();
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
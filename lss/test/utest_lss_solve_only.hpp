@@ -0,0 +1,97 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#ifndef cf3_lss_utest_lss_solve_only_hpp
+#define cf3_lss_utest_lss_solve_only_hpp
+
+
+#include <algorithm>
+#include <cmath>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Component.hpp"
+#include "cf3/lss/linearsystem.hpp"
+
+
+/* -- solving with a kept factorization (shared by the solvers utests) ------ */
+
+namespace utest {
+
+
+/// Dense (non-symmetric) system and right-hand side of given number
+inline void dense_system(cf3::lss::linearsystem< double >& lss, const size_t& nd, const size_t& r)
+{
+  for (size_t i=0; i<nd; ++i) {
+    for (size_t j=0; j<nd; ++j)
+      lss.A(i,j) = (i==j? static_cast< double >(nd) : 1./static_cast< double >(1+i+2*j));
+    lss.b(i) = 1. + static_cast< double >((i+r)%7) - 0.5*static_cast< double >(r);
+  }
+}
+
+
+/// Maximum difference of solutions
+inline double difference(const cf3::lss::linearsystem< double >& a, const cf3::lss::linearsystem< double >& b, const size_t& nd)
+{
+  double d = 0.;
+  for (size_t i=0; i<nd; ++i)
+    d = std::max(d,std::abs(a.x(i)-b.x(i)));
+  return d;
+}
+
+
+/// Solving with a kept factorization (factorize once, then solve_only for
+/// several right-hand sides) against full solves, also on a copy; the copy
+/// then factorizes a different (smaller) system, which must not affect the
+/// original's factorization (no shared solver handles)
+template< class LSS >
+void check_solve_only()
+{
+  using cf3::common::allocate_component;
+  const size_t nd = 50, ns = 20, nrhs = 3;
+  boost::shared_ptr< LSS >
+    full  = allocate_component< LSS >("full"),
+    reuse = allocate_component< LSS >("reuse"),
+    copy  = allocate_component< LSS >("copy"),
+    small = allocate_component< LSS >("small");
+  full ->initialize(nd,nd,1);
+  reuse->initialize(nd,nd,1);
+  dense_system(*reuse,nd,0);
+  BOOST_REQUIRE_NO_THROW( reuse->factorize() );
+  copy->copy(*reuse);
+
+  for (size_t r=0; r<nrhs; ++r) {
+    dense_system(*full,nd,r);
+    BOOST_REQUIRE_NO_THROW( full->solve() );
+    for (size_t i=0; i<nd; ++i)
+      reuse->b(i) = copy->b(i) = full->b(i);
+    BOOST_REQUIRE_NO_THROW( reuse->solve_only() );
+    BOOST_REQUIRE_NO_THROW( copy ->solve_only() );
+    BOOST_CHECK_SMALL( difference(*full,*reuse,nd), 1.e-12 );
+    BOOST_CHECK_SMALL( difference(*full,*copy, nd), 1.e-12 );
+    BOOST_CHECK( std::abs(full->x(0))>0. );
+  }
+
+  small->initialize(ns,ns,1);
+  dense_system(*small,ns,1);
+  BOOST_REQUIRE_NO_THROW( small->solve() );
+  copy->initialize(ns,ns,1);
+  dense_system(*copy,ns,1);
+  BOOST_REQUIRE_NO_THROW( copy->factorize() );
+  BOOST_REQUIRE_NO_THROW( copy->solve_only() );
+  BOOST_CHECK_SMALL( difference(*small,*copy,ns), 1.e-12 );
+
+  for (size_t i=0; i<nd; ++i)
+    reuse->x(i) = 0.;
+  BOOST_REQUIRE_NO_THROW( reuse->solve_only() );
+  BOOST_CHECK_SMALL( difference(*full,*reuse,nd), 1.e-12 );
+}
+
+
+}  // namespace utest
+
+
+#endif
@@ -0,0 +1,243 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::lss sparse_matrix"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include "cf3/lss/matrix.hpp"
+
+
+using namespace cf3;
+
+
+namespace {
+
+
+typedef lss::sparse_matrix< double, lss::sort_by_row, 1 > matrix_t;
+
+
+/// Compressed (tridiagonal) matrix of given size
+void tridiagonal(matrix_t& A, const size_t& n)
+{
+  std::vector< std::vector< size_t > > nnz(n);
+  for (size_t i=0; i<n; ++i)
+    for (size_t j=(i? i-1:0); j<std::min(n,i+2); ++j)
+      nnz[i].push_back(j);
+  A.initialize(n,n,nnz);
+}
+
+
+}  // namespace
+
+
+BOOST_AUTO_TEST_SUITE( lss_sparse_matrix )
+
+
+BOOST_AUTO_TEST_CASE( pattern_version )
+{
+  matrix_t A;
+  tridiagonal(A,5);
+  A.compress();
+  const size_t v = A.pattern_version();
+  BOOST_CHECK( v!=0 );
+
+  // values only, and uncompress/recompress cycle: same structure version
+  A.add(0,1,2.);
+  A = 3.;
+  A.compress();
+  BOOST_CHECK_EQUAL( A.pattern_version(), v );
+  A.uncompress();
+  A.compress();
+  BOOST_CHECK_EQUAL( A.pattern_version(), v );
+
+  // structural change: different version
+  A(0,4) += 1.;
+  A.compress();
+  const size_t w = A.pattern_version();
+  BOOST_CHECK( w!=v && w!=0 );
+
+  // copy: own (non-zero) version, changing only if the structure differs
+  matrix_t B;
+  B.initialize(3,3);
+  B = A;
+  B.compress();
+  const size_t vb = B.pattern_version();
+  BOOST_CHECK( vb!=0 );
+  B = A;
+  B.compress();
+  BOOST_CHECK_EQUAL( B.pattern_version(), vb );
+  tridiagonal(A,5);
+  A.compress();
+  B = A;
+  B.compress();
+  BOOST_CHECK( B.pattern_version()!=vb && B.pattern_version()!=0 );
+
+  // swap: both versions change if the structures differ
+  matrix_t C;
+  tridiagonal(C,7);
+  C.compress();
+  const size_t va = A.pattern_version(), vc = C.pattern_version();
+  A.swap(C);
+  BOOST_CHECK( A.pattern_version()!=va && A.pattern_version()!=0 );
+  BOOST_CHECK( C.pattern_version()!=vc && C.pattern_version()!=0 );
+  BOOST_CHECK_EQUAL( A.size(0), size_t(7) );
+  BOOST_CHECK_EQUAL( C.size(0), size_t(5) );
+
+  // same row pointers, different column indices: different version
+  std::vector< std::vector< size_t > > nnz(4);
+  for (size_t i=0; i<4; ++i) {
+    nnz[i].push_back(i);
+    nnz[i].push_back((i+1)%4);
+  }
+  matrix_t D;
+  D.initialize(4,4,nnz);
+  const size_t vd = D.pattern_version();
+  for (size_t i=0; i<4; ++i)
+    nnz[i][1] = (i+3)%4;
+  D.initialize(4,4,nnz);
+  const size_t wd = D.pattern_version();
+  BOOST_CHECK( wd!=vd );
+  D.initialize(4,4,nnz);
+  BOOST_CHECK_EQUAL( D.pattern_version(), wd );
+}
+
+
+BOOST_AUTO_TEST_CASE( triplet_assembly )
+{
+  matrix_t A;
+  const matrix_t& C = A;
+  A.initialize(4,4);
+
+  // triplets, including repeated entries, summed on compression
+  A.add(0,0,1.);
+  A.add(0,0,2.);
+  A.add(1,2,3.);
+  A.add(1,2,-1.);
+  A.add(3,0,5.);
+  A.compress();
+  BOOST_CHECK_EQUAL( C(0,0), 3. );
+  BOOST_CHECK_EQUAL( C(1,2), 2. );
+  BOOST_CHECK_EQUAL( C(2,1), 0. );  // (structurally symmetric pair)
+  BOOST_CHECK_EQUAL( C(3,0), 5. );
+  BOOST_CHECK_EQUAL( C(0,3), 0. );
+  BOOST_CHECK_EQUAL( C(2,2), 0. );
+
+  // existing entries accumulate in place, new ones on compression
+  const size_t v = A.pattern_version();
+  A.add(1,2,1.);
+  BOOST_CHECK_EQUAL( C(1,2), 3. );
+  BOOST_CHECK_EQUAL( A.pattern_version(), v );
+  A.add(2,3,4.);
+  A.add(2,3,4.);
+  A.compress();
+  BOOST_CHECK_EQUAL( C(2,3), 8. );
+  BOOST_CHECK_EQUAL( C(1,2), 3. );
+  BOOST_CHECK( A.pattern_version()!=v );
+}
+
+
+BOOST_AUTO_TEST_CASE( locked_assembly )
+{
+  // 1D mesh of two-node elements, assembled sequentially and concurrently
+  // (each entry sums at most two contributions, so results are identical)
+  const int n = 10000;
+  matrix_t S, P;
+  tridiagonal(S,n);
+  tridiagonal(P,n);
+
+  std::vector< size_t > r(2), c(2);
+  std::vector< double > v(4);
+  for (int e=0; e<n-1; ++e) {
+    r[0] = c[0] = e;
+    r[1] = c[1] = e+1;
+    v[0] = v[3] = static_cast< double >(e+1);
+    v[1] = v[2] = -static_cast< double >(e+1);
+    S.add_block(r,c,v);
+  }
+
+  P.lock();
+  #pragma omp parallel for schedule(dynamic,64) firstprivate(r,c,v)
+  for (int e=0; e<n-1; ++e) {
+    r[0] = c[0] = e;
+    r[1] = c[1] = e+1;
+    v[0] = v[3] = static_cast< double >(e+1);
+    v[1] = v[2] = -static_cast< double >(e+1);
+    P.add_block(r,c,v);
+  }
+  BOOST_CHECK_EQUAL( P.lock_misses(), size_t(0) );
+
+  // entries outside the structure: counted (block, single and indexed
+  // entries), ignored and not affecting out of bounds values
+  #pragma omp parallel for schedule(static) firstprivate(r,c,v)
+  for (int e=0; e<100; ++e) {
+    r[0] = e;
+    r[1] = e+1;
+    c[0] = e+3;
+    c[1] = e+4;
+    P.add_block(r,c,v);
+    P.add(e,e+5,1.);
+    P(e,e+6) = 1.;
+  }
+  BOOST_CHECK_EQUAL( P.lock_misses(), size_t(600) );
+  P.lock(false);
+
+  const matrix_t &CS = S, &CP = P;
+  size_t ndiff = 0;
+  for (int i=0; i<n; ++i)
+    for (int j=(i? i-1:0); j<std::min(n,i+2); ++j)
+      ndiff += (CS(i,j)!=CP(i,j)? 1:0);
+  BOOST_CHECK_EQUAL( ndiff, size_t(0) );
+  const double na = CP(n,0);
+  BOOST_CHECK( na!=na );
+}
+
+
+BOOST_AUTO_TEST_CASE( block_bounds )
+{
+  // inconsistent blocks are ignored (not thrown, also in parallel regions)
+  matrix_t A;
+  tridiagonal(A,10);
+  A.compress();
+  const matrix_t& C = A;
+  std::vector< size_t > r(2), c(2);
+  std::vector< double > v(4,1.);
+  r[0] = c[0] = 0;
+  r[1] = c[1] = 1;
+
+  A.lock();
+  #pragma omp parallel for schedule(static) firstprivate(r,c,v)
+  for (int e=0; e<8; ++e) {
+    std::vector< size_t > rr(r), cc(c);
+    rr[1] = 10+e;
+    cc[1] = 10+e;
+    A.add_block(r,c,std::vector< double >(3,1.));
+    A.add_block(rr,c,v);
+    A.add_block(r,cc,v);
+  }
+  BOOST_CHECK_EQUAL( A.lock_misses(), size_t(0) );
+  A.lock(false);
+
+  A.add_block(r,c,std::vector< double >(5,1.));
+  r[0] = 10;
+  A.add_block(r,c,v);
+  BOOST_CHECK_EQUAL( C(0,0), 0. );
+  BOOST_CHECK_EQUAL( C(0,1), 0. );
+  BOOST_CHECK_EQUAL( C(1,1), 0. );
+
+  // consistent block, for reference
+  r[0] = 0;
+  A.add_block(r,c,v);
+  BOOST_CHECK_EQUAL( C(0,0), 1. );
+  BOOST_CHECK_EQUAL( C(1,0), 1. );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -25,6 +25,8 @@ dss::dss(const std::string& name, const size_t& _size_i, const size_t& _size_j,
   : detail::solverbase(name)
 {
   handle = NULL;
+  analysed_pattern = 0;
+  factorized       = 0;
   for (int i=0; i<_ALL_PHASES; ++i)
     opts[i] = MKL_DSS_DEFAULTS;
   opts[ _STRUCTURE ] += MKL_DSS_SYMMETRIC_STRUCTURE;
@@ -48,14 +50,40 @@ dss::~dss()
 
 
 dss& dss::solve()
+{
+  return factorize().solve_only();
+}
+
+
+dss& dss::factorize()
 {
   matrix_t::matrix_compressed_t& A = m_A.compress();
+  int err;
+  factorized = 0;
+
+  // structure definition and reordering only if matrix structure changed
+  if (analysed_pattern!=m_A.pattern_version()) {
+    analysed_pattern = 0;
+    if ((err=dss_define_structure_(&handle, &opts[_STRUCTURE], &A.ia[0], &A.nnu, &A.nnu, &A.ja[0], &A.nnz))
+     || (err=dss_reorder_         (&handle, &opts[_REORDER],   NULL)) )
+      throw std::runtime_error(err_message(err));
+    analysed_pattern = m_A.pattern_version();
+  }
+  if ((err=dss_factor_real_(&handle, &opts[_FACTOR], &A.a[0])))
+    throw std::runtime_error(err_message(err));
+  factorized = m_A.pattern_version();
+  return *this;
+}
+
+
+dss& dss::solve_only()
+{
+  m_A.compress();
+  if (factorized!=m_A.pattern_version())
+    factorize();
   int nrhs = static_cast< int >(m_b.size(1));
   int err;
-  if ((err=dss_define_structure_(&handle, &opts[_STRUCTURE], &A.ia[0], &A.nnu, &A.nnu, &A.ja[0], &A.nnz))
-   || (err=dss_reorder_         (&handle, &opts[_REORDER],   NULL))
-   || (err=dss_factor_real_     (&handle, &opts[_FACTOR],    &A.a[0]))
-   || (err=dss_solve_real_      (&handle, &opts[_SOLVE],     &m_b.a[0], &nrhs, &m_x.a[0])) )
+  if ((err=dss_solve_real_(&handle, &opts[_SOLVE], &m_b.a[0], &nrhs, &m_x.a[0])))
     throw std::runtime_error(err_message(err));
   return *this;
 }
@@ -65,9 +93,17 @@ dss& dss::copy(const dss& _other)
 {
   linearsystem< double >::copy(_other);
   m_A = _other.m_A;
-  handle = _other.handle;
   for (int i=0; i<_ALL_PHASES; ++i)
     opts[i] = _other.opts[i];
+
+  // dss: independent handle (not shared, as it is deleted on destruction),
+  // forcing structure definition, reordering and factorization
+  int err;
+  analysed_pattern = 0;
+  factorized       = 0;
+  if ((err=dss_delete_(&handle, &opts[_DELETE]))
+   || (err=dss_create_(&handle, &opts[_CREATE])) )
+    throw std::runtime_error(err_message(err));
   return *this;
 }
 
@@ -48,6 +48,12 @@ class lss_API dss : public
   /// Linear system solving: x = A^-1 b
   dss& solve();
 
+  /// Linear system matrix factorization
+  dss& factorize();
+
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  dss& solve_only();
+
   /// Linear system copy
   dss& copy(const dss& _other);
 
@@ -60,6 +66,8 @@ class lss_API dss : public
 
   int opts[_ALL_PHASES];
   void *handle;
+  size_t analysed_pattern;  // matrix structure version of structure definition and reordering
+  size_t factorized;        // matrix structure version of numerical factorization
 
 };
 
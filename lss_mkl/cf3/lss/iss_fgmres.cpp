@@ -36,6 +36,8 @@ iss_fgmres::iss_fgmres(const std::string& name, const size_t& _size_i, const siz
 
   m_pc_type    = "none";
   m_pc_refresh = true;
+  m_pc_handle  = NULL;
+  m_pc_pattern = 0;
   m_monitor    = false;
   m_resnorm    = 1.e-12;
   opt.pc_type  = previous_opt.pc_type = NONE;
@@ -81,6 +83,7 @@ iss_fgmres::iss_fgmres(const std::string& name, const size_t& _size_i, const siz
 iss_fgmres::~iss_fgmres()
 {
   // release internal memory
+  precondition_release();
   MKL_Free_Buffers();
 }
 
@@ -91,55 +94,144 @@ iss_fgmres& iss_fgmres::solve()
 
 
   // local temporary variables
-  std::vector< double >
-    trvec,  // vector for preconditioner application
-    rhs,    // right-hand side vector
-    res;    // residual vector
-
   char cvar[3];
   double dvar;
   int
     RCI_request = 0,
     itercount = 0,
+    itermax = 0,
     inc = 1;
 
 
-  CFdebug << "mkl iss_fgmres: allocate temporary storage" << CFendl;
+  // temporary storage is kept between solves (only grown), the RCI workspace
+  // is the largest at n*(2*restart+1) + restart*(restart+9)/2 + 1
   const size_t tmp_size =
     m_A.size(0)*(2*opt.iparm_14+1) + (opt.iparm_14*(opt.iparm_14+9))/2 + 1;
-  if (tmp.size()!=tmp_size)
-    tmp.assign(tmp_size,0.);  // this is really really heavy!
+  if (tmp.size()<tmp_size) {
+    CFdebug << "mkl iss_fgmres: allocate temporary storage" << CFendl;
+    tmp.resize(tmp_size,0.);
+  }
+  trvec.resize(A.nnu);
+  sol  .resize(A.nnu);
+  res  .resize(A.nnu);
+
+
+  // solve each right-hand side (column), sharing the preconditioner
+  for (size_t k=0; k<size(2); ++k) {
+    double
+      *x = &m_x.a[k*A.nnu],
+      *b = &m_b.a[k*A.nnu];
+
+
+    // initialize the solver
+    dfgmres_init(&A.nnu, x, b, &RCI_request, iparm, dparm, &tmp[0]);
+    if (RCI_request)
+      throw std::runtime_error(err_message(RCI_request,opt.pc_type));
+
+
+    // update and check configuration parameters consistency
+    opt.pc_type = (m_pc_type=="ilu0"? ILU0 :
+                   m_pc_type=="ilut"? ILUT : NONE );
+    iparm[ 4] = opt.iparm__4;
+    iparm[ 7] = opt.iparm__7;
+    iparm[ 8] = opt.iparm__8;
+    iparm[ 9] = opt.iparm__9;
+    iparm[10] = opt.pc_type? 1:0;
+    iparm[11] = opt.iparm_11;
+    iparm[14] = opt.iparm_14;
+    dparm[ 0] = opt.dparm__0;
+    dparm[ 1] = opt.dparm__1;
+
+    dfgmres_check(&A.nnu, x, b, &RCI_request, iparm, dparm, &tmp[0]);
+    if (RCI_request)
+      throw std::runtime_error(err_message(RCI_request,opt.pc_type));
+    if (!k) {
+      CFdebug << "mkl iss_fgmres: possible RCI requests:"
+              <<              " 1"
+              << ( iparm[ 9]? " 2":"")
+              << ( iparm[10]? " 3":"")
+              << (!iparm[11]? " 4":"") << CFendl;
+      precondition_setup(A);
+    }
+    iparm[10] = opt.pc_type? 1:0;
+
+
+    // reverse communication loop
+    for (bool finished=false; !finished;) {
+      dfgmres(&A.nnu, x, b, &RCI_request, iparm, dparm, &tmp[0]);
+      switch (RCI_request) {
+
+        case 1:
+          // iterative step
+          // compute vector A*tmp[iparm[21]-1] into vector tmp[iparm[22]-1]
+          // NOTE: iparm[21] and [22] contain FORTRAN style addresses
+          cvar[0] = 'N';
+          mkl_dcsrgemv(&cvar[0], &A.nnu, &A.a[0], &A.ia[0], &A.ja[0], &tmp[iparm[21] - 1], &tmp[iparm[22] - 1]);
+          if (m_monitor) {
+            CFinfo << "mkl iss_fgmres: iteration " << iparm[3];
+            if (size(2)>1)
+              CFinfo << " (rhs " << k << ')';
+            CFinfo << CFendl;
+          }
+          break;
+
+        case 2:
+          // user-defined stopping test (check the residual norm)
+
+          // get solution into sol (temporary) and calculate current true residual
+          iparm[12] = 1;
+          cvar[0] = 'N';
+          dfgmres_get(&A.nnu, x, &sol[0], &RCI_request, iparm, dparm, &tmp[0], &itercount);
+          mkl_dcsrgemv(&cvar[0], &A.nnu, &A.a[0], &A.ia[0], &A.ja[0], &sol[0], &res[0]);
+
+          dvar = -1.;
+          daxpy(&A.nnu, &dvar, b, &inc, &res[0], &inc);
+          dvar = dnrm2(&A.nnu, &res[0], &inc);
+
+          finished = (dvar < m_resnorm);
+          if (finished)
+            RCI_request = 0;
+          break;
+
+        case 3:
+          // apply preconditioner on vector tmp[iparm[21]-1] into vector
+          // tmp[iparm[22]-1]
+          // NOTE: iparm[21] and [22] contain FORTRAN style addresses
+          precondition_apply(&tmp[iparm[21] - 1], &tmp[iparm[22] - 1]);
+          break;
+
+        case 4:
+          // check the norm of the generated vector is not too small
+          finished = (dparm[6] < 1.e-12);
+          if (finished)
+            RCI_request = 0;
+          break;
+
+        default:
+          // this indicates failure if RCI_request!=0
+          finished = true;
+          break;
+
+      }
+    }
 
 
-  // initialize the solver
-  dfgmres_init(&A.nnu, &m_x.a[0], &m_b.a[0], &RCI_request, iparm, dparm, &tmp[0]);
-  if (RCI_request)
-    throw std::runtime_error(err_message(RCI_request,opt.pc_type));
+    // get solution if successful (x still has initial guess) and iteration number
+    iparm[12] = RCI_request? -1:0;
+    dfgmres_get(&A.nnu, x, b, &RCI_request, iparm, dparm, &tmp[0], &itercount);
+    if ((RCI_request = (iparm[12] || (x[0]==x[0])? RCI_request : -10000)))
+      throw std::runtime_error(err_message(RCI_request,opt.pc_type));
+    itermax = std::max(itermax,itercount);
+  }
+  CFinfo << "mkl iss_fgmres: succeded, iterations: " << itermax << CFendl;
 
 
-  // update and check configuration parameters consistency
-  opt.pc_type = (m_pc_type=="ilu0"? ILU0 :
-                 m_pc_type=="ilut"? ILUT : NONE );
-  iparm[ 4] = opt.iparm__4;
-  iparm[ 7] = opt.iparm__7;
-  iparm[ 8] = opt.iparm__8;
-  iparm[ 9] = opt.iparm__9;
-  iparm[10] = opt.pc_type? 1:0;
-  iparm[11] = opt.iparm_11;
-  iparm[14] = opt.iparm_14;
-  dparm[ 0] = opt.dparm__0;
-  dparm[ 1] = opt.dparm__1;
-
-  dfgmres_check(&A.nnu, &m_x.a[0], &m_b.a[0], &RCI_request, iparm, dparm, &tmp[0]);
-  if (RCI_request)
-    throw std::runtime_error(err_message(RCI_request,opt.pc_type));
-  CFdebug << "mkl iss_fgmres: possible RCI requests:"
-          <<              " 1"
-          << ( iparm[ 9]? " 2":"")
-          << ( iparm[10]? " 3":"")
-          << (!iparm[11]? " 4":"") << CFendl;
+  return *this;
+}
 
 
+void iss_fgmres::precondition_setup(matrix_t::matrix_compressed_t& A)
+{
   /*
    * (re-)build preconditioner if necessary
    * Preconditioners may worsen the iterative convergence for arbitrary cases
@@ -148,23 +240,28 @@ iss_fgmres& iss_fgmres::solve()
   CFdebug << "mkl iss_fgmres: preconditioner: "
           << (opt.pc_type==ILU0? "ilu0" :
              (opt.pc_type==ILUT? "ilut" : "none" )) << CFendl;
-  RCI_request = 0;
-  if ( opt.pc_type==ILU0 && (m_pc_refresh
+  int RCI_request = 0;
+  bool rebuilt = true;
+  const bool changed = (m_pc_pattern!=m_A.pattern_version());
+  if ( opt.pc_type==ILU0 && (m_pc_refresh || changed
     || opt.pc_type != previous_opt.pc_type )) {
 
+    // (factor has the matrix structure, copied as the analysis refers to it)
+    precondition_release();
     m_pc.nnu = A.nnu;
     m_pc.nnz = A.nnz;
-    m_pc.ia.clear();
-    m_pc.ja.clear();
+    m_pc.ia  = A.ia;
+    m_pc.ja  = A.ja;
     m_pc.a .assign( m_pc.nnz, 0.);
     dcsrilu0(&A.nnu, &A.a[0], &A.ia[0], &A.ja[0], &m_pc.a[0], &iparm[0], &dparm[0], &RCI_request);
 
   }
-  else if ( opt.pc_type==ILUT && (m_pc_refresh
+  else if ( opt.pc_type==ILUT && (m_pc_refresh || changed
          || opt.pc_type != previous_opt.pc_type
          || opt.tol     != previous_opt.tol
          || opt.maxfil  != previous_opt.maxfil )) {
 
+    precondition_release();
     m_pc.nnu = A.nnu;
     m_pc.nnz = (2*opt.maxfil+1)*(A.nnu) - opt.maxfil*(opt.maxfil+1) + 1;
     m_pc.ia.assign( m_pc.nnu+1, 0 );
@@ -173,7 +270,7 @@ iss_fgmres& iss_fgmres::solve()
     dcsrilut(&A.nnu, &A.a[0], &A.ia[0], &A.ja[0], &m_pc.a[0], &m_pc.ia[0], &m_pc.ja[0], &opt.tol, &opt.maxfil, &iparm[0], &dparm[0], &RCI_request);
 
   }
-  else if (opt.pc_type && !m_pc_refresh) {}
+  else if (opt.pc_type && !m_pc_refresh) { rebuilt = false; }
   else {
 
     opt.pc_type = NONE;
@@ -188,89 +285,72 @@ iss_fgmres& iss_fgmres::solve()
     throw std::runtime_error(err_message(RCI_request,opt.pc_type));
 
 
-  // reverse communication loop
-  for (bool finished=false; !finished;) {
-    dfgmres(&A.nnu, &m_x.a[0], &m_b.a[0], &RCI_request, iparm, dparm, &tmp[0]);
-    switch (RCI_request) {
-
-      case 1:
-        // iterative step
-        // compute vector A*tmp[iparm[21]-1] into vector tmp[iparm[22]-1]
-        // NOTE: iparm[21] and [22] contain FORTRAN style addresses
-        cvar[0] = 'N';
-        mkl_dcsrgemv(&cvar[0], &A.nnu, &A.a[0], &A.ia[0], &A.ja[0], &tmp[iparm[21] - 1], &tmp[iparm[22] - 1]);
-        if (m_monitor)
-          CFinfo << "mkl iss_fgmres: iteration " << iparm[3] << CFendl;
-        break;
-
-      case 2:
-        // user-defined stopping test (check the residual norm)
-
-        // get solution into rhs (temporary) and calculate current true residual
-        iparm[12] = 1;
-        cvar[0] = 'N';
-        rhs.resize(A.nnu);
-        res.resize(A.nnu);
-        dfgmres_get(&A.nnu, &m_x.a[0], &rhs[0], &RCI_request, iparm, dparm, &tmp[0], &itercount);
-        mkl_dcsrgemv(&cvar[0], &A.nnu, &A.a[0], &A.ia[0], &A.ja[0], &rhs[0], &res[0]);
-
-        dvar = -1.;
-        daxpy(&A.nnu, &dvar, &m_b.a[0], &inc, &res[0], &inc);
-        dvar = dnrm2(&A.nnu, &res[0], &inc);
-
-        finished = (dvar < m_resnorm);
-        if (finished)
-          RCI_request = 0;
-        break;
-
-      case 3:
-        // apply preconditioner on vector tmp[iparm[21]-1] into vector
-        // tmp[iparm[22]-1]
-        // NOTE: iparm[21] and [22] contain FORTRAN style addresses
-        trvec.assign(A.nnu,0.);
-
-        cvar[0] = 'L';
-        cvar[1] = 'N';
-        cvar[2] = 'U';
-        mkl_dcsrtrsv( &cvar[0], &cvar[1], &cvar[2], &A.nnu, &m_pc.a[0],
-          (opt.pc_type==ILU0? &A.ia[0]:(opt.pc_type==ILUT? &m_pc.ia[0] : NULL)),
-          (opt.pc_type==ILU0? &A.ja[0]:(opt.pc_type==ILUT? &m_pc.ja[0] : NULL)),
-          &tmp[iparm[21] - 1], &trvec[0] );
-
-        cvar[0] = 'U';
-        cvar[1] = 'N';
-        cvar[2] = 'N';
-        mkl_dcsrtrsv( &cvar[0], &cvar[1], &cvar[2], &A.nnu, &m_pc.a[0],
-          (opt.pc_type==ILU0? &A.ia[0]:(opt.pc_type==ILUT? &m_pc.ia[0] : NULL)),
-          (opt.pc_type==ILU0? &A.ja[0]:(opt.pc_type==ILUT? &m_pc.ja[0] : NULL)),
-          &trvec[0], &tmp[iparm[22] - 1] );
-        break;
-
-      case 4:
-        // check the norm of the generated vector is not too small
-        finished = (dparm[6] < 1.e-12);
-        if (finished)
-          RCI_request = 0;
-        break;
-
-      default:
-        // this indicates failure if RCI_request!=0
-        finished = true;
-        break;
+  // (re-)analyse triangular solves only with the factor
+  if (!opt.pc_type)
+    precondition_release();
+  else if (rebuilt || m_pc_handle==NULL)
+    precondition_inspect(A);
+  m_pc_pattern = m_A.pattern_version();
+}
+
 
-    }
+void iss_fgmres::precondition_inspect(matrix_t::matrix_compressed_t& A)
+{
+  // (the handle refers to the factor arrays, which are not copied)
+  precondition_release();
+  if (SPARSE_STATUS_SUCCESS!=mkl_sparse_d_create_csr( &m_pc_handle,
+        SPARSE_INDEX_BASE_ONE, A.nnu, A.nnu,
+        &m_pc.ia[0], &m_pc.ia[1], &m_pc.ja[0], &m_pc.a[0] )) {
+    m_pc_handle = NULL;
+    throw std::runtime_error("mkl iss_fgmres: preconditioner analysis failed (mkl_sparse_d_create_csr)");
   }
 
+  // hint L and U solves at every iteration, then analyse (failure is not
+  // critical, the solves are still correct but not optimized)
+  struct matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_TRIANGULAR;
+  const int ncalls = std::max(opt.iparm__4,1);
+  sparse_status_t stat = SPARSE_STATUS_SUCCESS;
+  descr.mode = SPARSE_FILL_MODE_LOWER;
+  descr.diag = SPARSE_DIAG_UNIT;
+  stat = (stat!=SPARSE_STATUS_SUCCESS? stat :
+    mkl_sparse_set_sv_hint(m_pc_handle, SPARSE_OPERATION_NON_TRANSPOSE, descr, ncalls) );
+  descr.mode = SPARSE_FILL_MODE_UPPER;
+  descr.diag = SPARSE_DIAG_NON_UNIT;
+  stat = (stat!=SPARSE_STATUS_SUCCESS? stat :
+    mkl_sparse_set_sv_hint(m_pc_handle, SPARSE_OPERATION_NON_TRANSPOSE, descr, ncalls) );
+  stat = (stat!=SPARSE_STATUS_SUCCESS? stat :
+    mkl_sparse_optimize(m_pc_handle) );
+  if (stat!=SPARSE_STATUS_SUCCESS)
+    CFwarn << "mkl iss_fgmres: preconditioner triangular solves not optimized (status " << stat << ")" << CFendl;
+}
 
-  // get solution if successful (x still has initial guess) and iteration number
-  iparm[12] = RCI_request? -1:0;
-  dfgmres_get(&A.nnu, &m_x.a[0], &m_b.a[0], &RCI_request, iparm, dparm, &tmp[0], &itercount);
-  if ((RCI_request = (iparm[12] || (x(0)==x(0))? RCI_request : -10000)))
-    throw std::runtime_error(err_message(RCI_request,opt.pc_type));
-  CFinfo << "mkl iss_fgmres: " << (RCI_request? "failed":"succeded") << ", iterations: " << itercount << CFendl;
 
+void iss_fgmres::precondition_apply(const double* x, double* y)
+{
+  // forward (unit diagonal L) then backward (U) substitution, through trvec
+  struct matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_TRIANGULAR;
+  descr.mode = SPARSE_FILL_MODE_LOWER;
+  descr.diag = SPARSE_DIAG_UNIT;
+  sparse_status_t stat = mkl_sparse_d_trsv(
+    SPARSE_OPERATION_NON_TRANSPOSE, 1., m_pc_handle, descr, x, &trvec[0] );
+
+  descr.mode = SPARSE_FILL_MODE_UPPER;
+  descr.diag = SPARSE_DIAG_NON_UNIT;
+  stat = (stat!=SPARSE_STATUS_SUCCESS? stat : mkl_sparse_d_trsv(
+    SPARSE_OPERATION_NON_TRANSPOSE, 1., m_pc_handle, descr, &trvec[0], y ) );
+  if (stat!=SPARSE_STATUS_SUCCESS)
+    throw std::runtime_error("mkl iss_fgmres: preconditioner application failed (mkl_sparse_d_trsv)");
+}
 
-  return *this;
+
+void iss_fgmres::precondition_release()
+{
+  if (m_pc_handle!=NULL)
+    mkl_sparse_destroy(m_pc_handle);
+  m_pc_handle  = NULL;
+  m_pc_pattern = 0;
 }
 
 
@@ -279,6 +359,7 @@ iss_fgmres& iss_fgmres::copy(const iss_fgmres& _other)
   linearsystem< double >::copy(_other);
   m_A          = _other.m_A;
   m_pc         = _other.m_pc;
+  precondition_release();  // (analysis is not shared, recalculated on solve)
   m_pc_type    = _other.m_pc_type;
   m_pc_refresh = _other.m_pc_refresh;
   m_monitor    = _other.m_monitor;
@@ -292,6 +373,16 @@ iss_fgmres& iss_fgmres::copy(const iss_fgmres& _other)
 }
 
 
+iss_fgmres& iss_fgmres::swap(iss_fgmres& _other)
+{
+  // matrices are swapped but not factors, so force their recalculation
+  solverbase::swap(_other);
+  precondition_release();
+  _other.precondition_release();
+  return *this;
+}
+
+
 const std::string iss_fgmres::err_message(const int& err, const pc_t& _pc_type)
 {
   std::ostringstream s;
@@ -13,6 +13,10 @@
 #include "detail_solverbase.h"
 
 
+// MKL inspector-executor sparse matrix handle (as in mkl_spblas.h)
+struct sparse_matrix;
+
+
 namespace cf3 {
 namespace lss {
 namespace mkl {
@@ -53,6 +57,9 @@ class lss_API iss_fgmres : public
   /// Linear system copy
   iss_fgmres& copy(const iss_fgmres& _other);
 
+  /// Linear system swap
+  iss_fgmres& swap(iss_fgmres& _other);
+
 
  private:
   // internal functions and storage
@@ -60,9 +67,24 @@ class lss_API iss_fgmres : public
   /// Verbose error message
   static const std::string err_message(const int& err, const pc_t& _pc_type);
 
+  /// Preconditioner (re-)calculation, if necessary
+  void precondition_setup(matrix_t::matrix_compressed_t& A);
+
+  /// Preconditioner triangular solves analysis (inspection), for the
+  /// parallel application of the L and U factors
+  void precondition_inspect(matrix_t::matrix_compressed_t& A);
+
+  /// Preconditioner application: y = (LU)^-1 x
+  void precondition_apply(const double* x, double* y);
+
+  /// Preconditioner analysis release
+  void precondition_release();
+
   matrix_t::matrix_compressed_t m_pc;          // preconditioner matrix
   std::string                   m_pc_type;     // ... type name
   bool                          m_pc_refresh;  // ... force recalculation
+  ::sparse_matrix*              m_pc_handle;   // ... analysis (inspector-executor handle)
+  size_t                        m_pc_pattern;  // ... matrix structure version of factor and analysis
   bool                          m_monitor;     // monitor iterations
   double                        m_resnorm;     // maximum residual norm (if test_user is set)
   struct {
@@ -81,7 +103,11 @@ class lss_API iss_fgmres : public
       dparm__1;
   } opt,                      // options (current)
     previous_opt;             // options (previous, for caching)
-  std::vector< double > tmp;  // space for computations
+  std::vector< double > tmp;  // space for computations (RCI workspace)
+  std::vector< double >
+    trvec,                    // ... preconditioner application
+    sol,                      // ... current solution (user-defined stopping test)
+    res;                      // ... and its residual
   int    iparm[128];
   double dparm[128];
 
@@ -5,6 +5,9 @@
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
 
+#include <cmath>
+#include <limits>
+
 #include "mkl_pardiso.h"
 #include "mkl_service.h"
 
@@ -66,6 +69,24 @@ pardiso::pardiso(
       ", and 11: nonsymmetric" );
   options().add("mtype", mtype).link_to(&mtype).description("This scalar value defines the matrix type ("+desc_mtype+")").mark_basic();
 
+  // reordering and symbolic factorization are reused if matrix structure and
+  // type are unchanged, unless forced
+  reanalyse = false;
+  analysed_pattern = 0;
+  analysed_mtype   = mtype;
+  factorized       = 0;
+  options().add("reanalyse", reanalyse).link_to(&reanalyse).description("if reordering and symbolic factorization are performed on every solve (default false, only if matrix structure or type changed)").mark_basic();
+
+  // mixed precision: single precision factorization and solving (iparm[27],
+  // on single precision copies of matrix and vectors), double precision
+  // accuracy is recovered by iterative refinement with double residuals
+  mixed = false;
+  analysed_single = false;
+  anorm = 0.;
+  options().add("maxits", iparm[ 7]).link_to(&iparm[ 7]).description("Max. numbers of iterative refinement steps (default 0: automatic, or 30 with MixedPrecision)").mark_basic();
+  options().add("MixedPrecision", mixed).link_to(&mixed).description("if numerical factorization is in single precision, recovering double precision accuracy by iterative refinement, otherwise factorizing in double precision (default false)").mark_basic();
+  properties().add("iterations",int(0));
+
   detail::solverbase::initialize(_size_i,_size_j,_size_k);
 }
 
@@ -77,25 +98,52 @@ pardiso::~pardiso()
 
 
 pardiso& pardiso::solve()
+{
+  return factorize().solve_only();
+}
+
+
+pardiso& pardiso::factorize()
+{
+  factorization(mixed);
+  return *this;
+}
+
+
+pardiso& pardiso::solve_only()
 {
   int err;
-  if ( (err=call_pardiso(11,0)) ||  // 11: reordering and symbolic factorization
-       (err=call_pardiso(22,0)) ||  // 22: numerical factorization and
-       (err=call_pardiso(33,0)) )   // 33: back substitution and iterative refinement
+  m_A.compress();
+  if (factorized!=m_A.pattern_version())
+    factorize();
+  if (analysed_single && solve_refine())
+    return *this;
+
+  if ((err=call_pardiso(33,0)))     // 33: back substitution and iterative refinement
     throw std::runtime_error(err_message(err));
+  properties()["iterations"] = iparm[6];
   return *this;
 }
 
 
 pardiso& pardiso::copy(const pardiso& _other)
 {
+  // pardiso: independent handle (not shared, as it keeps the analysis and
+  // factors, and is released on destruction), own memory released first
+  call_pardiso(-1,0);
+  for (size_t i=0; i<64; ++i) pt[i] = NULL;
+  PARDISOINIT(pt,&mtype,iparm);
+
   linearsystem< double >::copy(_other);
   m_A = _other.m_A;
-  for (size_t i=0; i<64; ++i) pt   [i] = _other.pt   [i];
   for (size_t i=0; i<64; ++i) iparm[i] = _other.iparm[i];
   maxfct = _other.maxfct;
   mnum   = _other.mnum;
   mtype  = _other.mtype;
+  reanalyse        = _other.reanalyse;
+  mixed            = _other.mixed;
+  analysed_pattern = 0;  // (force reordering and symbolic factorization)
+  factorized       = 0;
   return *this;
 }
 
@@ -126,16 +174,122 @@ const std::string pardiso::err_message(const int& err)
 }
 
 
+void pardiso::factorization(const bool& _single)
+{
+  int err;
+  matrix_t::matrix_compressed_t& A = m_A.compress();
+  factorized = 0;
+
+  // single precision matrix copy (if in range) and its infinity norm
+  bool single = _single;
+  for (int k=0; k<A.nnz && single; ++k)
+    single = (std::abs(A.a[k])<=static_cast< double >(std::numeric_limits< float >::max()));
+  if (_single && !single)
+    CFwarn << "mkl pardiso: matrix not representable in single precision, factorizing in double precision." << CFendl;
+  if (single) {
+    as.assign(A.a.begin(),A.a.end());
+    anorm = 0.;
+    for (int i=0; i<A.nnu; ++i) {
+      double s = 0.;
+      for (int k=A.ia[i]-1; k<A.ia[i+1]-1; ++k)
+        s += std::abs(A.a[k]);
+      anorm = std::max(anorm,s);
+    }
+  }
+  else
+    as.clear();
+
+  // precision is set for reordering (iparm[27], it cannot change afterwards)
+  if ( reanalyse ||
+       analysed_pattern!=m_A.pattern_version() ||
+       analysed_mtype  !=mtype ||
+       analysed_single !=single ) {
+    analysed_pattern = 0;
+    analysed_single  = single;
+    iparm[27] = (single? 1:0);
+    if ((err=call_pardiso(11,0)))   // 11: reordering and symbolic factorization
+      throw std::runtime_error(err_message(err));
+    analysed_pattern = m_A.pattern_version();
+    analysed_mtype   = mtype;
+  }
+  if ((err=call_pardiso(22,0)))     // 22: numerical factorization
+    throw std::runtime_error(err_message(err));
+  factorized = m_A.pattern_version();
+}
+
+
+bool pardiso::solve_refine()
+{
+  int err;
+  const int
+    n      = static_cast< int >(size(0)),
+    nrhs   = static_cast< int >(size(2)),
+    maxits = (iparm[7]>0? iparm[7] : 30);
+  const size_t nb = m_b.a.size();
+  const double tol = anorm*std::numeric_limits< double >::epsilon()*std::sqrt(static_cast< double >(n));
+
+  // (PARDISO refinement is in single precision, so it is not used)
+  const int iparm7 = iparm[7];
+  iparm[7] = 0;
+  r = m_b.a;
+  bs.resize(nb);
+  xs.resize(nb);
+  int its = 0;
+  for (bool converged=false; !converged; ++its) {
+
+    // single precision correction d = A^-1 r, added to x (x = d initially)
+    for (size_t k=0; k<nb; ++k)
+      bs[k] = static_cast< float >(r[k]);
+    if ((err=call_pardiso(33,0))) {
+      iparm[7] = iparm7;
+      throw std::runtime_error(err_message(err));
+    }
+    for (size_t k=0; k<nb; ++k)
+      m_x.a[k] = (its? m_x.a[k] : 0.) + static_cast< double >(xs[k]);
+
+    // double precision residual r = b - A x, and convergence check
+    r = m_b.a;
+    m_A.multi(&m_x.a[0],&r[0],nrhs,-1.,1.);
+    converged = true;
+    for (int k=0; k<nrhs && converged; ++k) {
+      double rnorm = 0., xnorm = 0.;
+      for (int i=0; i<n; ++i) {
+        rnorm = std::max(rnorm,std::abs(r[k*n+i]));
+        xnorm = std::max(xnorm,std::abs(m_x.a[k*n+i]));
+      }
+      converged = (rnorm<=xnorm*tol);
+    }
+
+    if (!converged && its+1>=maxits) {
+      iparm[7] = iparm7;
+      CFwarn << "mkl pardiso: mixed precision iterative refinement not converged in " << (its+1) << " steps, factorizing in double precision." << CFendl;
+      factorization(false);
+      properties()["iterations"] = its+1;
+      return false;
+    }
+  }
+  iparm[7] = iparm7;
+  properties()["iterations"] = its;
+  return true;
+}
+
+
 int pardiso::call_pardiso(int _phase, int _msglvl)
 {
   matrix_t::matrix_compressed_t& A = m_A.compress();
   int nrhs = static_cast< int >(m_b.size(1));
 
+  // single precision factorization works on single precision copies
+  void
+    *a = (!analysed_single? (void*) &A.a[0]   : as.size()? (void*) &as[0] : NULL),
+    *b = (!analysed_single? (void*) &m_b.a[0] : bs.size()? (void*) &bs[0] : NULL),
+    *x = (!analysed_single? (void*) &m_x.a[0] : xs.size()? (void*) &xs[0] : NULL);
+
   int err = 0;
   PARDISO(
     pt, &maxfct, &mnum, &mtype, &_phase,
-    &A.nnu, &A.a[0], &A.ia[0], &A.ja[0],
-    NULL, &nrhs, iparm, &_msglvl, &m_b.a[0], &m_x.a[0], &err );
+    &A.nnu, a, &A.ia[0], &A.ja[0],
+    NULL, &nrhs, iparm, &_msglvl, b, x, &err );
   return err;
 }
 
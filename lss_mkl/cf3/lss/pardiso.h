@@ -43,6 +43,12 @@ class lss_API pardiso : public
   /// Linear system solving: x = A^-1 b
   pardiso& solve();
 
+  /// Linear system matrix factorization (reordering only if necessary)
+  pardiso& factorize();
+
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  pardiso& solve_only();
+
   /// Linear system copy
   pardiso& copy(const pardiso& _other);
 
@@ -53,6 +59,17 @@ class lss_API pardiso : public
   /// Verbose error message
   static const std::string err_message(const int& err);
 
+  /// Numerical factorization (reordering only if necessary), in single or
+  /// double precision
+  void factorization(const bool& _single);
+
+  /// Mixed precision solving by iterative refinement: x = A^-1 b in single
+  /// precision, then x += A^-1 (b - A x) with the residual in double precision,
+  /// until ||r|| <= ||x|| ||A|| eps sqrt(n) (infinity norms) for all
+  /// right-hand sides; if not converged, falls back to double precision
+  /// factorization (and returns false)
+  bool solve_refine();
+
   /// Library call
   int call_pardiso(int _phase, int _msglvl);
 
@@ -62,6 +79,20 @@ class lss_API pardiso : public
         mnum,
         mtype;
 
+  bool   reanalyse;         // if symbolic factorization is forced on every solve
+  size_t analysed_pattern;  // matrix structure version of symbolic factorization
+  int    analysed_mtype;    // ... and matrix type
+  size_t factorized;        // matrix structure version of numerical factorization
+
+  bool   mixed;             // if factorization is in single precision (mixed precision solving)
+  bool   analysed_single;   // ... as set for symbolic factorization
+  double anorm;             // ... matrix infinity norm (for refinement convergence)
+  std::vector< float >
+    as,                     // ... single precision matrix,
+    bs,                     // ... right-hand side and
+    xs;                     // ... solution
+  std::vector< double > r;  // ... residual (double precision)
+
 };
 
 
@@ -71,6 +71,10 @@ pardiso::pardiso(const std::string& name, const size_t& _size_i, const size_t& _
   options().add("mtype",  mtype    ).link_to(&mtype    ).description("This scalar value defines the matrix type ("+desc_mtype+")").mark_basic();
   options().add("solver", iparm[31]).link_to(&iparm[31]).description("This scalar value defines the solver method ("+desc_solver+")").mark_basic();
   options().add("maxits", iparm[ 7]).link_to(&iparm[ 7]).description("Max. numbers of iterative refinement steps").mark_basic();
+  options().add("MixedPrecision", iparm[28]).link_to(&iparm[28]).description("[0|1] numerical factorization in double or single precision, recovering double precision accuracy by iterative refinement (real matrices only, see maxits)").mark_basic();
+  properties().add("iterations",int(0));
+
+  factorized = 0;
 
   linearsystem< double >::initialize(_size_i,_size_j,_size_k);
 }
@@ -83,41 +87,63 @@ pardiso::~pardiso()
 
 
 pardiso& pardiso::solve()
+{
+  return factorize().solve_only();
+}
+
+
+pardiso& pardiso::factorize()
 {
   int err;
+  factorized = 0;
   if ( (err=call_pardiso_printstats()) ||  // check for matrix/vector consistency
        (err=call_pardiso(11,0))        ||  // 11: reordering and symbolic factorization
-       (err=call_pardiso(22,0))        ||  // 22: numerical factorization and
-       (err=call_pardiso(33,0)) )          // 33: back substitution and iterative refinement
+       (err=call_pardiso(22,0)) )          // 22: numerical factorization
+    throw std::runtime_error(err_message(err));
+  factorized = m_A.pattern_version();
+  return *this;
+}
+
+
+pardiso& pardiso::solve_only()
+{
+  int err;
+  m_A.compress();
+  if (factorized!=m_A.pattern_version())
+    factorize();
+  if ((err=call_pardiso(33,0)))            // 33: back substitution and iterative refinement
     throw std::runtime_error(err_message(err));
+  properties()["iterations"] = iparm[6];
   return *this;
 }
 
 
 pardiso& pardiso::multi(const double& _alpha, const double& _beta)
 {
-  matrix_t::matrix_compressed_t& A = m_A.compress();
-  for (size_t i=0; i<size(0); ++i) {
-    for (size_t k=0; k<size(2); ++k) {
-      b(i,k) *= _beta;
-      for (size_t l=A.ia[i]-A.ia[0]; l<A.ia[i+1]-A.ia[0]; ++l)
-        b(i,k) += _alpha*A.a[l]*m_x( A.ja[l]-A.ia[0], k);
-    }
-  }
+  m_A.multi(&m_x.a[0],&m_b.a[0],size(2),_alpha,_beta);
   return *this;
 }
 
 
 pardiso& pardiso::copy(const pardiso& _other)
 {
+  // pardiso: independent handle (not shared, as it keeps the analysis and
+  // factors, and is released on destruction), own memory released first
+  int err = 0;
+  call_pardiso(-1,0);
+  std::fill(&pt[0],&pt[0]+64,static_cast< void* >(NULL));
+  pardisoinit_(pt,&mtype,&iparm[31],iparm,dparm,&err);
+  if (err)
+    throw std::runtime_error(err_message(err));
+
   linearsystem< double >::copy(_other);
   m_A = _other.m_A;
-  std::copy(&_other.pt   [0],&_other.pt   [0]+64,&pt   [0]);
   std::copy(&_other.dparm[0],&_other.dparm[0]+64,&dparm[0]);
   std::copy(&_other.iparm[0],&_other.iparm[0]+64,&iparm[0]);
   maxfct = _other.maxfct;
   mnum   = _other.mnum;
   mtype  = _other.mtype;
+  factorized = 0;
   return *this;
 }
 
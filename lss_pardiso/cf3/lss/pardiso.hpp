@@ -44,6 +44,12 @@ class lss_API pardiso : public linearsystem< double >
   /// Linear system solving: x = A^-1 b
   pardiso& solve();
 
+  /// Linear system matrix factorization
+  pardiso& factorize();
+
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  pardiso& solve_only();
+
   /// Linear system forward multiplication: b = alpha A x + beta b
   pardiso& multi(const double& _alpha=1., const double& _beta=0.);
 
@@ -80,6 +86,8 @@ class lss_API pardiso : public linearsystem< double >
   void A___clear()                      { m_A.clear();    }
   void A___zerorow(const size_t& i)     { m_A.zerorow(i); }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
+  void A___add_block(const std::vector< size_t >& _rows, const std::vector< size_t >& _cols, const std::vector< double >& _values) { m_A.add_block(_rows,_cols,_values); }
+  bool A___lock(const bool& _lock) { m_A.lock(_lock); return true; }
 
   void   A___print(std::ostream& o, const print_t& l=print_auto) const { m_A.print(o,l); }
   size_t A___size(const size_t& d)  const { return m_A.size(d);  }
@@ -94,6 +102,7 @@ class lss_API pardiso : public linearsystem< double >
          maxfct,
          mnum,
          mtype;
+  size_t factorized;  // matrix structure version of numerical factorization
 
 };
 
@@ -0,0 +1,30 @@
+// Copyright (C) 2014 Vrije Universiteit Brussel, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::lss pardiso"
+
+#include <boost/test/unit_test.hpp>
+
+#include "cf3/lss/pardiso.hpp"
+#include "../../lss/test/utest_lss_solve_only.hpp"
+
+
+using namespace cf3;
+
+
+BOOST_AUTO_TEST_SUITE( lss_pardiso )
+
+
+BOOST_AUTO_TEST_CASE( factorize_solve_only )
+{
+  utest::check_solve_only< lss::pardiso >();
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -133,7 +133,7 @@ petsc_seq& petsc_seq::solve()
 
 petsc_seq& petsc_seq::multi(const double& _alpha, const double& _beta)
 {
-  //TODO
+  m_A.multi(&m_x.a[0],&m_b.a[0],size(2),_alpha,_beta);
   return *this;
 }
 
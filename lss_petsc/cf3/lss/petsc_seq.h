@@ -80,6 +80,8 @@ class lss_API petsc_seq : public linearsystem< double >
   void A___clear()                      { m_A.clear();    }
   void A___zerorow(const size_t& i)     { m_A.zerorow(i); }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
+  void A___add_block(const std::vector< size_t >& _rows, const std::vector< size_t >& _cols, const std::vector< double >& _values) { m_A.add_block(_rows,_cols,_values); }
+  bool A___lock(const bool& _lock) { m_A.lock(_lock); return true; }
 
   void   A___print(std::ostream& o, const print_t& l=print_auto) const { m_A.print(o,l); }
   size_t A___size(const size_t& d)  const { return m_A.size(d);  }
@@ -53,22 +53,57 @@ WSMP::WSMP(const std::string& name, const size_t& _size_i, const size_t& _size_j
   for (size_t i=0; i<64; ++i) dparm[i] = 0.;
 
   // reset pt, iparm and dparm defaults
-  call_wsmp(0);
+  call_wsmp(0,0);
   iparm[ 3] = 0;  // CSR matrix format
   iparm[ 4] = 0;  // + C-style numbering
   iparm[19] = 2;  // + ordering option 5
+  analysed_pattern = 0;
+  factorized       = 0;
+
+  // analysis statistics, to estimate memory and choose between solvers
+  properties().add("factor_nnz",  int(0));
+  properties().add("factor_flops",double(0.));
 
   linearsystem< double >::initialize(_size_i,_size_j,_size_k);
 }
 
 
 WSMP& WSMP::solve()
+{
+  return factorize().solve_only();
+}
+
+
+WSMP& WSMP::factorize()
+{
+  int err;
+  m_A.compress();
+  factorized = 0;
+  if (analysed_pattern!=m_A.pattern_version()) {
+    analysed_pattern = 0;
+    if ((err=call_wsmp(1,1)))   // 1: analysis and reordering
+      throw std::runtime_error(err_message(err));
+    analysed_pattern = m_A.pattern_version();
+    properties()["factor_nnz"]   = iparm[23];
+    properties()["factor_flops"] = dparm[23];
+  }
+  if ((err=call_wsmp(2,2)))     // 2: LU factorization
+    throw std::runtime_error(err_message(err));
+  factorized = m_A.pattern_version();
+  return *this;
+}
+
+
+WSMP& WSMP::solve_only()
 {
   int err;
-  if ( (err=call_wsmp(1)) ||  // 1: analysis and reordering
-       (err=call_wsmp(2)) ||  // 2: LU factorization
-       (err=call_wsmp(3)) ||  // 3: forward and backward elimination
-       (err=call_wsmp(4)) )   // 4: iterative refinement
+  m_A.compress();
+  if (factorized!=m_A.pattern_version())
+    factorize();
+
+  // solution overwrites the right-hand side, so it is solved on x (b is kept)
+  m_x.a = m_b.a;
+  if ((err=call_wsmp(3,4)))     // 3: forward and backward elimination, 4: iterative refinement
     throw std::runtime_error(err_message(err));
 
   /*
@@ -80,7 +115,6 @@ WSMP& WSMP::solve()
    * dparm[25]: task ? summary residual
    */
 
-  m_b.swap(m_x);
   return *this;
 }
 
@@ -88,18 +122,21 @@ WSMP& WSMP::solve()
 WSMP& WSMP::multi(const double& _alpha, const double& _beta)
 {
   matrix_t::matrix_compressed_t& A = m_A.compress();
-  vector_t b = m_b;
 
-  int err = 0;
-  for (int k=0, fmt(iparm[3]+1); k<static_cast< int >(size(2)) && !err;  ++k)
+  // single vector plain product: WSMP's own, directly into b
+  if (size(2)==1 && _alpha==1. && _beta==0.) {
+    int err = 0, fmt(iparm[3]+1);
     wgsmatvec_(
       &A.nnu, &A.ia[0], &A.ja[0], &A.a[0],
-      &m_x.a[A.nnu*k], &b.a[A.nnu*k], &fmt, &err );
-  if (err)
-    throw std::runtime_error(err_message(err));
+      &m_x.a[0], &m_b.a[0], &fmt, &err );
+    if (err)
+      throw std::runtime_error(err_message(err));
+    return *this;
+  }
 
-  for (size_t i=0; i<m_b.a.size(); ++i)
-    m_b.a[i] = _alpha*b.a[i] + _beta*m_b.a[i];
+  // otherwise, fused b = alpha A x + beta b for all vectors (the matrix is
+  // swept once per block of vectors, without temporary copies of b)
+  m_A.multi(&m_x.a[0],&m_b.a[0],size(2),_alpha,_beta);
   return *this;
 }
 
@@ -112,6 +149,8 @@ WSMP& WSMP::copy(const WSMP& _other)
     dparm[i] = _other.dparm[i];
     iparm[i] = _other.iparm[i];
   }
+  analysed_pattern = 0;  // (force analysis and reordering)
+  factorized       = 0;
   return *this;
 }
 
@@ -145,18 +184,19 @@ const std::string WSMP::err_message(const int& err)
 }
 
 
-int WSMP::call_wsmp(int _phase)
+int WSMP::call_wsmp(int _task, int _task_last)
 {
   matrix_t::matrix_compressed_t& A = m_A.compress();
-  int nrhs = static_cast< int >(m_b.size(1)),
-      ldb  = static_cast< int >(m_b.size(0)),
+  int nrhs = static_cast< int >(m_x.size(1)),
+      ldb  = static_cast< int >(m_x.size(0)),
      &fact = iparm[30],
       ldlt_pivot(fact==2 || fact==4 || fact==6 || fact==7);
 
-  iparm[1] = iparm[2] = _phase;
+  iparm[1] = _task;
+  iparm[2] = _task_last;
   wgsmp_(
     &A.nnu,&A.ia[0],&A.ja[0],&A.a[0],
-    &m_b.a[0],&ldb,&nrhs,NULL,iparm,dparm);
+    &m_x.a[0],&ldb,&nrhs,NULL,iparm,dparm);
 
   iparm[63] = (iparm[63]>0 && ldlt_pivot? 0 : iparm[63]);
   return iparm[63];
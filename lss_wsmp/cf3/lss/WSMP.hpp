@@ -41,6 +41,12 @@ class lss_API WSMP : public linearsystem< double >
   /// Linear system solving: x = A^-1 b
   WSMP& solve();
 
+  /// Linear system matrix factorization
+  WSMP& factorize();
+
+  /// Linear system solving: x = A^-1 b, reusing the matrix factorization
+  WSMP& solve_only();
+
   /// Linear system forward multiplication: b = alpha A x + beta b
   WSMP& multi(const double& _alpha=1., const double& _beta=0.);
 
@@ -57,8 +63,9 @@ class lss_API WSMP : public linearsystem< double >
   /// Verbose error message
   static const std::string err_message(const int& err);
 
-  /// Library call
-  int call_wsmp(int _phase);
+  /// Library call, performing tasks from _task to _task_last (solution
+  /// tasks work in place on the solution vector)
+  int call_wsmp(int _task, int _task_last);
 
 
  protected:
@@ -74,6 +81,8 @@ class lss_API WSMP : public linearsystem< double >
   void A___clear()                      { m_A.clear();    }
   void A___zerorow(const size_t& i)     { m_A.zerorow(i); }
   void A___sumrows(const size_t& i, const size_t& isrc) { m_A.sumrows(i,isrc); }
+  void A___add_block(const std::vector< size_t >& _rows, const std::vector< size_t >& _cols, const std::vector< double >& _values) { m_A.add_block(_rows,_cols,_values); }
+  bool A___lock(const bool& _lock) { m_A.lock(_lock); return true; }
 
   void   A___print(std::ostream& o, const print_t& l=print_auto) const { m_A.print(o,l); }
   size_t A___size(const size_t& d)  const { return m_A.size(d);  }
@@ -84,6 +93,8 @@ class lss_API WSMP : public linearsystem< double >
   matrix_t m_A;
   double dparm[64];
   int    iparm[64];
+  size_t analysed_pattern;  // matrix structure version of analysis and reordering
+  size_t factorized;        // matrix structure version of numerical factorization
 
 };
 